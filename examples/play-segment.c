@@ -41,6 +41,9 @@ int main(int argc, char** argv) {
 	//    a filename and returns a memory buffer and its length as an output parameter. The context pointer
 	//    is user-defined, here it's just a path string. You can return NULL from a resolver to indicate that
 	//    the file was not found.
+	//
+	//    If your files are in a plain directory on disk, you can also use DmLoader_addDirectoryResolver instead,
+	//    which indexes the directory once and maps files into memory instead of reading them.
 
 	char* cwd = getcwd(NULL, 0);
 	rv = DmLoader_addResolver(loader, dm_resolve_file, cwd);
@@ -124,6 +124,25 @@ typedef void* DmMemoryAlloc(void* ctx, size_t len);
 /// \see Dm_setHeapAllocator Set the memory allocator for the library.
 typedef void DmMemoryFree(void* ctx, void* ptr);
 
+/// \brief A `realloc`-like memory re-allocation function.
+///
+/// Resizes the memory block pointed to by \p ptr, which was previously allocated by calling a corresponding
+/// #DmMemoryAlloc or #DmMemoryRealloc function, to \p len bytes. The contents of the block are preserved up to the
+/// lesser of the old and new sizes. If \p ptr is `NULL`, this function must behave like #DmMemoryAlloc. If
+/// re-allocation fails, the function must return NULL and leave the original block untouched.
+///
+/// \warning Functions implementing this interface are required to be thread-safe.
+///
+/// \param ctx[in] An arbitrary pointer provided when calling #Dm_setHeapAllocator.
+/// \param ptr[in] A pointer to re-allocate, previously returned by the corresponding allocation functions or `NULL`.
+/// \param len[in] The new size of the memory block in bytes.
+///
+/// \return A pointer to the first byte of the re-allocated memory block or NULL.
+/// \retval NULL Memory re-allocation failed.
+///
+/// \see Dm_setHeapReallocator Set the memory re-allocator for the library.
+typedef void* DmMemoryRealloc(void* ctx, void* ptr, size_t len);
+
 /// \brief Set the memory allocator to use internally.
 ///
 ///	This function should be called before calling any other library functions since, calling it after any allocation
@@ -132,9 +151,12 @@ typedef void DmMemoryFree(void* ctx, void* ptr);
 ///
 /// \warning This function is **not** thread safe.
 ///
+/// Memory allocated using a custom allocator is resized by allocating a new block and copying the old one over,
+/// unless a matching re-allocation function is set using #Dm_setHeapReallocator afterward.
+///
 /// \param alloc[in] A `malloc`-like function, which allocates memory. May not be NULL.
 /// \param free[in] A `free`-like function, which free memory previously allocated using \p alloc. May not be NULL.
-/// \param ctx[in] An arbitrary pointer passed to \p alloc and \p free on every invocation.
+/// \param ctx[in] An arbitrary pointer passed to \p alloc, \p free and the re-allocator on every invocation.
 ///
 /// \return #DmResult_SUCCESS if the operation completed and an error code if it did not.
 /// \retval #DmResult_INVALID_ARGUMENT Either \p alloc or \p free was `NULL`.
@@ -144,6 +166,22 @@ typedef void DmMemoryFree(void* ctx, void* ptr);
 /// \see DmMemoryFree De-allocation function definition.
 DMAPI DmResult Dm_setHeapAllocator(DmMemoryAlloc* alloc, DmMemoryFree* free, void* ctx);
 
+/// \brief Set the memory re-allocator to use internally.
+///
+/// The re-allocator must match the allocator set using #Dm_setHeapAllocator, which resets it, so this function has
+/// to be called after it. Like #Dm_setHeapAllocator, it must be called before any allocation has been made.
+///
+/// \warning This function is **not** thread safe.
+///
+/// \param realloc[in] A `realloc`-like function, which resizes memory previously allocated using the allocator. May be
+///                    NULL, in which case memory is resized by allocating a new block and copying the old one.
+///
+/// \return #DmResult_SUCCESS if the operation completed and an error code if it did not.
+/// \retval #DmResult_INVALID_STATE The function was called after an allocation was already made.
+///
+/// \see DmMemoryRealloc Re-allocation function definition.
+DMAPI DmResult Dm_setHeapReallocator(DmMemoryRealloc* realloc);
+
 /// \brief A `rand_r`-like random number generation function.
 ///
 /// Generates a random number between 0 and UINT32_MAX. Functions implementing this interface must be
@@ -158,12 +196,15 @@ typedef uint32_t DmRng(void* ctx);
 
 /// \brief Set the random number generator to use internally.
 ///
-/// The given random number generator is sampled every time the library requires a random number. This includes
-/// but is not limited to:
+/// The given random number generator is sampled whenever the library requires a random seed. Each performance
+/// owns its own pseudo-random number generator which is seeded from this function when it is created. That
+/// generator is then used for
 ///
-///  * Selecting the next pattern to be played,
+///  * selecting the next pattern to be played,
 ///  * selecting the next note/curve variation and
-///  * applying random note offsets
+///  * applying random note offsets.
+///
+/// To make the playback of a performance reproducible, use #DmPerformance_setRandomSeed instead.
 ///
 /// \param rng[in] A pointer to a function to use as a random number generator or `NULL`
 ///                to reset to the default random number generator.
@@ -376,6 +417,19 @@ typedef enum DmLoaderOptions {
 	/// \brief Automatically download references.
 	DmLoader_DOWNLOAD = 1U << 0U,
 
+	/// \brief Decode the waves of DLS collections on demand.
+	///
+	/// By default, all waves of a DLS collection are decoded when it is first used by a performance. With this
+	/// option, only the waves of instruments actually assigned to a channel are decoded, when they are first
+	/// assigned. Address space for the decoded waves is reserved up front, but memory is only committed for each
+	/// wave as it is decoded.
+	///
+	/// Waves which are never played are never read, so for collections resolved from memory-mapped files (see
+	/// #DmLoader_addDirectoryResolver and #DmLoader_addPackResolver), they are never loaded from disk either.
+	/// Collections returned by #DmLoader_addResolver or #DmLoader_addBufferResolver are already in memory, so
+	/// the whole file stays resident with or without this option; only the decoded waves are saved.
+	DmLoader_STREAM = 1U << 1U,
+
 	/// \brief Default options for loader objects.
 	DmLoader_DEFAULT = 0U,
 } DmLoaderOptions;
@@ -397,6 +451,36 @@ typedef enum DmLoaderOptions {
 ///         buffer is transferred to the loader.**
 typedef void* DmLoaderResolverCallback(void* ctx, char const* file, size_t* len);
 
+/// \brief A function used to release a memory buffer returned by a #DmLoaderBufferResolverCallback.
+///
+/// \param ctx[in] The context pointer returned by the resolver alongside the buffer.
+/// \param buf[in] The buffer to release.
+/// \param len The length of the buffer in bytes.
+typedef void DmLoaderBufferRelease(void* ctx, void* buf, size_t len);
+
+/// \brief A function used to look up DirectMusic objects by file name without copying them.
+///
+/// This works like #DmLoaderResolverCallback, except that the returned buffer is not de-allocated using `free`.
+/// Instead, the function provides a \p release function which is called with \p release_ctx once the loader no longer
+/// needs the buffer. This allows passing memory-mapped files or views into archives to the loader directly.
+///
+/// The buffer is never written to by the library and must stay valid until it is released. Depending on the type
+/// of object loaded, this can be for as long as the object is alive.
+///
+/// \param ctx[in] An arbitrary pointer provided when calling #DmLoader_addBufferResolver.
+/// \param file[in] The name of the file to look up.
+/// \param len[out] The length of the returned memory buffer in bytes.
+/// \param release[out] The function to call to release the returned buffer. If set to `NULL`, the buffer is
+///                     de-allocated like a buffer returned by #DmLoaderResolverCallback.
+/// \param release_ctx[out] An arbitrary pointer to pass to \p release.
+///
+/// \return A memory buffer containing the file data or `NULL` if the lookup failed.
+typedef void* DmLoaderBufferResolverCallback(void* ctx,
+                                             char const* file,
+                                             size_t* len,
+                                             DmLoaderBufferRelease** release,
+                                             void** release_ctx);
+
 /// \brief Create a new DirectMusic Loader object.
 ///
 /// If the #DmLoader_DOWNLOAD option is defined, all references for objects retrieved for the loader
@@ -429,6 +513,10 @@ DMAPI void DmLoader_release(DmLoader* slf);
 /// look up an object, it calls all resolvers in sequential order until one returns a match. If no match
 /// is found, an error is issued and the object is not loaded.
 ///
+/// \warning Resolvers are called without holding any of the loader's locks, so that files can be read concurrently.
+///          If the loader is used from multiple threads, \p resolve may be called concurrently and must be
+///          thread-safe.
+///
 /// \param slf[in] The loader to add a resolver to.
 /// \param resolve[in] The callback function used to resolve a file using the new resolver.
 /// \param ctx[in] An arbitrary pointer passed to \p resolve on every invocation.
@@ -439,6 +527,81 @@ DMAPI void DmLoader_release(DmLoader* slf);
 /// \retval #DmResult_MUTEX_ERROR An error occurred while trying to lock an internal mutex.
 DMAPI DmResult DmLoader_addResolver(DmLoader* slf, DmLoaderResolverCallback* resolve, void* ctx);
 
+/// \brief Add a zero-copy resolver to the loader.
+///
+/// Buffer resolvers are called in the same order as resolvers added using #DmLoader_addResolver, but they
+/// provide a custom function for releasing the buffers they return. See #DmLoaderBufferResolverCallback
+/// for details.
+///
+/// \param slf[in] The loader to add a resolver to.
+/// \param resolve[in] The callback function used to resolve a file using the new resolver.
+/// \param ctx[in] An arbitrary pointer passed to \p resolve on every invocation.
+///
+/// \return #DmResult_SUCCESS if the operation completed and an error code if it did not.
+/// \retval #DmResult_INVALID_ARGUMENT \p slf or \p resolve was `NULL`.
+/// \retval #DmResult_MEMORY_EXHAUSTED A dynamic memory allocation failed.
+/// \retval #DmResult_MUTEX_ERROR An error occurred while trying to lock an internal mutex.
+///
+/// \see #DmLoader_addResolver
+DMAPI DmResult DmLoader_addBufferResolver(DmLoader* slf, DmLoaderBufferResolverCallback* resolve, void* ctx);
+
+/// \brief Add a resolver which loads files from a directory on disk.
+///
+/// The directory is scanned once when this function is called and all files in it are indexed by their name.
+/// Lookups are case-insensitive and only consider the last component of the requested path. Sub-directories
+/// are not searched. Files are not read into memory, instead they are mapped read-only and paged in on demand.
+///
+/// Files added to the directory after this function was called are not found by the resolver.
+///
+/// \param slf[in] The loader to add a resolver to.
+/// \param path[in] The path of the directory to load files from.
+///
+/// \return #DmResult_SUCCESS if the operation completed and an error code if it did not.
+/// \retval #DmResult_INVALID_ARGUMENT \p slf or \p path was `NULL`.
+/// \retval #DmResult_NOT_FOUND The directory could not be opened.
+/// \retval #DmResult_MEMORY_EXHAUSTED A dynamic memory allocation failed.
+/// \retval #DmResult_MUTEX_ERROR An error occurred while trying to lock an internal mutex.
+///
+/// \see #DmLoader_addBufferResolver
+DMAPI DmResult DmLoader_addDirectoryResolver(DmLoader* slf, char const* path);
+
+/// \brief Add a resolver which loads files from a pack file.
+///
+/// Pack files bundle the contents of a directory into a single file with a sorted index of file names. They are
+/// created using #Dm_writePack or the `dmusic-pack` tool. The pack file is mapped into memory once and files
+/// are served directly from that mapping, so loading a file does not require any further I/O operations or copies.
+/// Lookups are case-insensitive and only consider the last component of the requested path.
+///
+/// \param slf[in] The loader to add a resolver to.
+/// \param path[in] The path of the pack file to load files from.
+///
+/// \return #DmResult_SUCCESS if the operation completed and an error code if it did not.
+/// \retval #DmResult_INVALID_ARGUMENT \p slf or \p path was `NULL`.
+/// \retval #DmResult_NOT_FOUND The pack file could not be opened.
+/// \retval #DmResult_FILE_CORRUPT The pack file is not valid.
+/// \retval #DmResult_MEMORY_EXHAUSTED A dynamic memory allocation failed.
+/// \retval #DmResult_MUTEX_ERROR An error occurred while trying to lock an internal mutex.
+///
+/// \see #Dm_writePack
+DMAPI DmResult DmLoader_addPackResolver(DmLoader* slf, char const* path);
+
+/// \brief Create a pack file from the contents of a directory.
+///
+/// All files in the given directory are added to the pack file. Sub-directories are not included. If the names
+/// of two files only differ in case, only one of them is added.
+///
+/// \param directory[in] The path of the directory to pack.
+/// \param output[in] The path of the pack file to create. If the file exists, it is overwritten.
+///
+/// \return #DmResult_SUCCESS if the operation completed and an error code if it did not.
+/// \retval #DmResult_INVALID_ARGUMENT \p directory or \p output was `NULL`.
+/// \retval #DmResult_NOT_FOUND The directory could not be opened or the pack file could not be created.
+/// \retval #DmResult_FILE_CORRUPT Writing the pack file failed.
+/// \retval #DmResult_MEMORY_EXHAUSTED A dynamic memory allocation failed.
+///
+/// \see #DmLoader_addPackResolver
+DMAPI DmResult Dm_writePack(char const* directory, char const* output);
+
 /// \brief Get a segment from the loader's cache or load it by file \p name.
 ///
 /// Gets a segment from the loader's cache or loads the segment using the resolvers added to the loader. If the
@@ -460,6 +623,344 @@ DMAPI DmResult DmLoader_addResolver(DmLoader* slf, DmLoaderResolverCallback* res
 /// \see #DmLoader_addResolver
 DMAPI DmResult DmLoader_getSegment(DmLoader* slf, char const* name, DmSegment** segment);
 
+/// \brief Metadata about a segment obtained using #DmLoader_probeSegment.
+typedef struct DmSegmentInfo {
+	/// \brief The GUID of the segment.
+	DmGuid guid;
+
+	/// \brief The name of the segment in UTF-8. Empty if the segment has no name.
+	char name[128];
+
+	/// \brief The number of seconds one repeat of the segment takes, as returned by #DmSegment_getLength.
+	double length;
+
+	/// \brief The number of repetitions, as returned by #DmSegment_getRepeats.
+	uint32_t repeats;
+
+	/// \brief The initial tempo of the segment in beats per minute or 100 if it has no tempo track.
+	double tempo;
+} DmSegmentInfo;
+
+/// \brief Read metadata about a segment without loading it.
+///
+/// Only the segment's header, GUID, name and tempo tracks are read. Unlike #DmLoader_getSegment, no bands or
+/// styles are parsed and no segment object is created, which makes this function suitable for indexing a large
+/// number of segments. The segment is neither cached nor downloaded.
+///
+/// \param slf[in] The loader to resolve the segment with.
+/// \param name[in] The file name of the segment to probe.
+/// \param info[out] A pointer to a variable in which to store the segment's metadata.
+///
+/// \return #DmResult_SUCCESS if the operation completed and an error code if it did not.
+/// \retval #DmResult_INVALID_ARGUMENT \p slf, \p name or \p info was `NULL`.
+/// \retval #DmResult_NOT_FOUND No segment with the given name could be found.
+/// \retval #DmResult_FILE_CORRUPT The segment file could not be parsed.
+///
+/// \see #DmLoader_getSegment
+DMAPI DmResult DmLoader_probeSegment(DmLoader* slf, char const* name, DmSegmentInfo* info);
+
+/// \brief A callback function invoked when an asynchronous segment load started using #DmLoader_getSegmentAsync
+///        completes.
+///
+/// \param ctx The user-defined context pointer passed to #DmLoader_getSegmentAsync.
+/// \param rv #DmResult_SUCCESS if the segment was loaded and an error code as returned by #DmLoader_getSegment if
+///           it was not.
+/// \param segment The loaded segment or `NULL` if loading it failed. The callee is given a strong reference to the
+///                segment which must be released using #DmSegment_release.
+typedef void DmLoaderSegmentCallback(void* ctx, DmResult rv, DmSegment* segment);
+
+/// \brief Load a segment by file \p name on a background thread.
+///
+/// This function behaves like #DmLoader_getSegment, except that it returns immediately and performs all work on a
+/// pool of worker threads owned by the loader. If the loader was created with the #DmLoader_DOWNLOAD option, the
+/// styles, bands and DLS collections referenced by the segment are loaded in parallel. Once loading is complete,
+/// \p cb is invoked from one of the worker threads.
+///
+/// \note Resolvers added to the loader will be called from the worker threads.
+/// \note The loader is kept alive until \p cb has returned, so the loader may be released before the load completes
+///       or from within \p cb.
+///
+/// \param slf[in] The loader to load the segment with.
+/// \param name The file name of the segment to load.
+/// \param cb The function to call once the segment has been loaded.
+/// \param ctx An arbitrary pointer passed to \p cb.
+///
+/// \return #DmResult_SUCCESS if the load was started and an error code if it was not.
+/// \retval #DmResult_INVALID_ARGUMENT \p slf, \p name or \p cb was `NULL`.
+/// \retval #DmResult_MEMORY_EXHAUSTED A dynamic memory allocation failed or the worker threads could not be started.
+/// \retval #DmResult_MUTEX_ERROR An error occurred while trying to lock an internal mutex.
+///
+/// \see #DmLoader_getSegment
+DMAPI DmResult DmLoader_getSegmentAsync(DmLoader* slf, char const* name, DmLoaderSegmentCallback* cb, void* ctx);
+
+/// \brief Store synthesizer fonts built from DLS collections in a directory on disk.
+///
+/// Before a DLS collection can be played, all of its instruments and samples are converted into a synthesizer font,
+/// which includes decoding all samples. If a font cache directory is set, the converted font is written to a file
+/// in that directory the first time it is built. Later, when the same collection is loaded again, possibly by
+/// another process, the font is memory-mapped from that file instead, skipping the conversion.
+///
+/// Cache files are named after the GUID of the collection. They are rebuilt automatically if the collection's
+/// version or size changes or if they were created by an incompatible version of the library. Collections without
+/// a GUID are never cached. Cache files use the byte order of the machine which created them and should not be
+/// shared between platforms.
+///
+/// The directory only applies to collections loaded after this function was called.
+///
+/// \param slf[in] The loader to set the font cache directory of.
+/// \param path[in] The path of an existing directory to store cache files in or `NULL` to disable caching.
+///
+/// \return #DmResult_SUCCESS if the operation completed and an error code if it did not.
+/// \retval #DmResult_INVALID_ARGUMENT \p slf was `NULL`.
+/// \retval #DmResult_MEMORY_EXHAUSTED A dynamic memory allocation failed.
+/// \retval #DmResult_MUTEX_ERROR An error occurred while trying to lock an internal mutex.
+DMAPI DmResult DmLoader_setFontCacheDirectory(DmLoader* slf, char const* path);
+
+/// \brief Options for #DmLoader_preload.
+typedef enum DmPreloadOptions {
+	/// \brief Build the synthesizer fonts for all DLS collections used by the segments. This decodes all
+	///        samples in the collections ahead of time.
+	DmPreload_FONTS = 1U << 0U,
+
+	/// \brief Read every page of the DLS collections and styles used by the segments, so that files provided as
+	///        memory mappings are paged in. The segments' own files are only read if the segments are returned to
+	///        the caller.
+	DmPreload_TOUCH = 1U << 1U,
+
+	/// \brief Default options for preloading. Segments are only loaded and downloaded.
+	DmPreload_DEFAULT = 0U,
+} DmPreloadOptions;
+
+/// \brief The outcome of preloading a single segment using #DmLoader_preload.
+typedef struct DmPreloadResult {
+	/// \brief #DmResult_SUCCESS if the segment was preloaded and an error code if it was not.
+	DmResult result;
+
+	/// \brief The time spent resolving and parsing the segment in seconds.
+	double load_time;
+
+	/// \brief The time spent downloading the segment's bands and styles in seconds.
+	double download_time;
+
+	/// \brief The time spent building synthesizer fonts and touching memory in seconds.
+	double warm_up_time;
+} DmPreloadResult;
+
+/// \brief Load and download a set of segments ahead of time.
+///
+/// All segments are loaded in parallel by the loader's worker threads. The DLS collections and styles they
+/// reference are downloaded into the loader's caches. Depending on \p opt, synthesizer fonts are built as well,
+/// which avoids decoding samples when a segment is first played.
+///
+/// If \p segments is not `NULL`, the downloaded segments are stored in it and can be passed to
+/// #DmPerformance_playSegment right away. Otherwise, they are released before this function returns. Segments are
+/// not cached by the loader, since playing a segment modifies it, so subsequent calls to #DmLoader_getSegment parse
+/// them again but find everything they reference in the loader's caches.
+///
+/// \warning Do not call this function from a #DmLoaderSegmentCallback. It waits for the loader's worker threads,
+///          which may dead-lock if it is called on one of them.
+///
+/// \param slf[in] The loader to preload segments with.
+/// \param names[in] The names of the segments to preload.
+/// \param count The number of elements in \p names.
+/// \param opt A bitfield containing additional work to perform for each segment.
+/// \param segments[out] An array of \p count elements in which to store the downloaded segments or `NULL`. Segments
+///                      which failed to preload are set to `NULL`. The caller must release all other segments
+///                      using #DmSegment_release.
+/// \param results[out] An array of \p count elements in which to store the outcome and timings for each segment
+///                     or `NULL`.
+///
+/// \return #DmResult_SUCCESS if all segments were preloaded and the first error encountered if not.
+/// \retval #DmResult_INVALID_ARGUMENT \p slf was `NULL` or \p names was `NULL` while \p count was not zero.
+/// \retval #DmResult_MEMORY_EXHAUSTED A dynamic memory allocation failed.
+/// \retval #DmResult_MUTEX_ERROR An error occurred while trying to lock an internal mutex.
+///
+/// \see #DmLoader_getSegment
+DMAPI DmResult DmLoader_preload(DmLoader* slf,
+                                char const* const* names,
+                                size_t count,
+                                DmPreloadOptions opt,
+                                DmSegment** segments,
+                                DmPreloadResult* results);
+
+/// \brief Statistics about the DLS collections and styles cached by a loader.
+/// \see DmLoader_getCacheStats
+typedef struct DmLoaderCacheStats {
+	/// \brief The number of times a requested object was already cached or being loaded.
+	size_t hits;
+
+	/// \brief The number of times a requested object was not cached and had to be loaded.
+	size_t misses;
+
+	/// \brief The number of objects removed from the cache to stay within the memory budget.
+	size_t evictions;
+
+	/// \brief The number of times a file was not looked up because none of the resolvers found it before.
+	/// \see DmLoader_invalidateMissing
+	size_t missing_hits;
+
+	/// \brief The total size of all cached objects in bytes, including the samples of their synthesizer fonts.
+	size_t memory_used;
+
+	/// \brief The memory budget set using #DmLoader_setMemoryBudget or 0 if there is none.
+	size_t memory_budget;
+} DmLoaderCacheStats;
+
+/// \brief Limit the amount of memory used by objects cached in the loader.
+///
+/// Every DLS collection and style loaded by the loader is cached, so that it can be shared between segments. Bands
+/// embedded in segments are cached as well, so that identical bands are shared. By default, cached objects are kept
+/// until the loader is released. Setting a memory budget causes the loader to evict the least recently used objects
+/// once the total size of all cached objects exceeds the budget. The size of an object is the size of the file it
+/// was loaded from, or the size of the band in memory. Once the synthesizer font of a DLS collection has been built,
+/// its samples are counted as well. With #DmLoader_STREAM, only the samples of waves decoded so far are counted.
+///
+/// Only objects which are not referenced by any segment or performance are evicted, so the budget may be exceeded
+/// while many objects are in use. Eviction happens whenever an object is loaded and when this function is called.
+///
+/// \param slf[in] The loader to set the memory budget of.
+/// \param budget The maximum number of bytes of cached objects to keep or 0 to disable eviction.
+///
+/// \return #DmResult_SUCCESS if the operation completed and an error code if it did not.
+/// \retval #DmResult_INVALID_ARGUMENT \p slf was `NULL`.
+/// \retval #DmResult_MUTEX_ERROR An error occurred while trying to lock an internal mutex.
+DMAPI DmResult DmLoader_setMemoryBudget(DmLoader* slf, size_t budget);
+
+/// \brief Get statistics about the objects cached by the loader.
+///
+/// \param slf[in] The loader to get the statistics of.
+/// \param stats[out] A pointer to a variable in which to store the statistics.
+///
+/// \return #DmResult_SUCCESS if the operation completed and an error code if it did not.
+/// \retval #DmResult_INVALID_ARGUMENT \p slf or \p stats was `NULL`.
+/// \retval #DmResult_MUTEX_ERROR An error occurred while trying to lock an internal mutex.
+DMAPI DmResult DmLoader_getCacheStats(DmLoader* slf, DmLoaderCacheStats* stats);
+
+/// \brief Forget that files could not be found by the loader's resolvers.
+///
+/// The loader remembers the names of files which none of its resolvers could find, so that repeated requests for
+/// them don't query every resolver again. Adding a resolver forgets all of these names automatically. If files are
+/// added to a location searched by an existing resolver, this function must be called for them to be found.
+///
+/// \param slf[in] The loader to invalidate the missing files of.
+/// \param name[in] The name of the file to forget or `NULL` to forget all missing files.
+///
+/// \return #DmResult_SUCCESS if the operation completed and an error code if it did not.
+/// \retval #DmResult_INVALID_ARGUMENT \p slf was `NULL`.
+/// \retval #DmResult_MUTEX_ERROR An error occurred while trying to lock an internal mutex.
+DMAPI DmResult DmLoader_invalidateMissing(DmLoader* slf, char const* name);
+
+/// \brief Statistics about a single resolver of a loader.
+/// \see DmLoader_getResolverStats
+typedef struct DmLoaderResolverStats {
+	/// \brief The number of files the resolver found.
+	size_t hits;
+
+	/// \brief The number of files the resolver was asked for but did not find.
+	size_t misses;
+} DmLoaderResolverStats;
+
+/// \brief Get statistics about each resolver added to the loader.
+///
+/// The statistics are stored in the order in which the resolvers were added. If \p stats has fewer than the number
+/// of resolvers elements, only the statistics of the first resolvers are stored.
+///
+/// \param slf[in] The loader to get the resolver statistics of.
+/// \param stats[out] An array of \p count elements in which to store the statistics. May be `NULL` if \p count
+///                   points to 0.
+/// \param count[in,out] The number of elements in \p stats. Set to the number of resolvers added to the loader.
+///
+/// \return #DmResult_SUCCESS if the operation completed and an error code if it did not.
+/// \retval #DmResult_INVALID_ARGUMENT \p slf or \p count was `NULL` or \p stats was `NULL` and \p count did not
+///                                   point to 0.
+/// \retval #DmResult_MUTEX_ERROR An error occurred while trying to lock an internal mutex.
+DMAPI DmResult DmLoader_getResolverStats(DmLoader* slf, DmLoaderResolverStats* stats, size_t* count);
+
+/// \brief The kinds of files loaded by a loader.
+/// \see DmLoader_getStats
+typedef enum DmLoaderAssetType {
+	DmLoaderAsset_SEGMENT = 0,
+	DmLoaderAsset_STYLE = 1,
+	DmLoaderAsset_DLS = 2,
+} DmLoaderAssetType;
+
+/// \brief Statistics about the files loaded by a loader.
+///
+/// All times are measured using a monotonic clock. Allocations are counted on the thread loading the file, so
+/// allocations made by helper threads, like the ones decoding DLS samples in parallel, are not included.
+///
+/// \see DmLoader_getStats
+/// \see DmLoader_getAssetStats
+typedef struct DmLoaderStats {
+	/// \brief The number of times a file was loaded.
+	size_t count;
+
+	/// \brief The time spent by the resolvers reading files in seconds.
+	double resolve_time;
+
+	/// \brief The number of bytes returned by the resolvers.
+	size_t bytes_read;
+
+	/// \brief The time spent parsing files in seconds.
+	double parse_time;
+
+	/// \brief The number of heap allocations made while parsing files.
+	size_t allocations;
+
+	/// \brief The number of bytes allocated while parsing files.
+	size_t allocated_bytes;
+
+	/// \brief The time spent building or loading the synthesizer fonts of DLS collections in seconds. Always 0
+	///        for segments and styles.
+	double font_time;
+} DmLoaderStats;
+
+/// \brief Statistics about a single file loaded by a loader.
+/// \see DmLoader_getAssetStats
+typedef struct DmLoaderAssetStats {
+	/// \brief The kind of file which was loaded.
+	DmLoaderAssetType type;
+
+	/// \brief The name of the file, truncated to fit.
+	char name[128];
+
+	/// \brief The result of the last time the file was loaded.
+	DmResult result;
+
+	/// \brief Statistics accumulated over all times the file was loaded.
+	DmLoaderStats stats;
+} DmLoaderAssetStats;
+
+/// \brief Get statistics about all files of one kind loaded by the loader.
+///
+/// Statistics are collected for every file found by the loader's resolvers. Styles and DLS collections are only
+/// counted when they are not already cached.
+///
+/// \param slf[in] The loader to get the statistics of.
+/// \param type The kind of files to get the statistics of.
+/// \param stats[out] A pointer to a variable in which to store the statistics.
+///
+/// \return #DmResult_SUCCESS if the operation completed and an error code if it did not.
+/// \retval #DmResult_INVALID_ARGUMENT \p slf or \p stats was `NULL`.
+/// \retval #DmResult_MUTEX_ERROR An error occurred while trying to lock an internal mutex.
+DMAPI DmResult DmLoader_getStats(DmLoader* slf, DmLoaderAssetType type, DmLoaderStats* stats);
+
+/// \brief Get statistics about each file loaded by the loader.
+///
+/// The statistics are stored in the order in which the files were first loaded. If \p stats has fewer than the
+/// number of files elements, only the statistics of the first files are stored.
+///
+/// \param slf[in] The loader to get the statistics of.
+/// \param stats[out] An array of \p count elements in which to store the statistics. May be `NULL` if \p count
+///                   points to 0.
+/// \param count[in,out] The number of elements in \p stats. Set to the number of files loaded by the loader.
+///
+/// \return #DmResult_SUCCESS if the operation completed and an error code if it did not.
+/// \retval #DmResult_INVALID_ARGUMENT \p slf or \p count was `NULL` or \p stats was `NULL` and \p count did not
+///                                   point to 0.
+/// \retval #DmResult_MUTEX_ERROR An error occurred while trying to lock an internal mutex.
+DMAPI DmResult DmLoader_getAssetStats(DmLoader* slf, DmLoaderAssetStats* stats, size_t* count);
+
 /// \}
 
 /// \addtogroup DmPerformanceGroup
@@ -476,6 +977,85 @@ typedef enum DmRenderOptions {
 	DmRender_STEREO = 1 << 2,
 } DmRenderOptions;
 
+/// \brief The types of events output by #DmPerformance_renderEvents.
+typedef enum DmEventType {
+	/// \brief A note should start playing. Uses `channel`, `note` and `velocity`.
+	DmEvent_NOTE_ON = 0,
+
+	/// \brief A note should stop playing. Uses `channel` and `note`.
+	DmEvent_NOTE_OFF = 1,
+
+	/// \brief All notes on all channels should stop playing.
+	DmEvent_NOTE_OFF_ALL = 2,
+
+	/// \brief A MIDI control change. Uses `channel`, `control`, `value` and, if `reset` is set, `reset_value`.
+	DmEvent_CONTROL = 3,
+
+	/// \brief A pitch bend. Uses `channel`, `bend` and, if `reset` is set, `reset_bend`.
+	DmEvent_PITCH_BEND = 4,
+
+	/// \brief An instrument change as requested by a band. Uses `channel`, `bank`, `preset` and `transpose`.
+	DmEvent_PROGRAM = 5,
+
+	/// \brief The volume, pan and pitch bend of all channels should return to their reset values. These are set by
+	///        control change and pitch bend events which have `reset` set, and default to full volume, center pan and
+	///        no pitch bend. Sent after #DmEvent_NOTE_OFF_ALL when a pattern or segment is stopped.
+	DmEvent_RESET = 6,
+} DmEventType;
+
+/// \brief A single MIDI-like event output by #DmPerformance_renderEvents.
+typedef struct DmEvent {
+	/// \brief The type of event. Determines which of the other fields are valid.
+	DmEventType type;
+
+	/// \brief The offset of the event in samples, relative to the start of the current render call.
+	uint32_t frame;
+
+	/// \brief The absolute music time of the event in ticks.
+	uint32_t time;
+
+	/// \brief The performance channel the event applies to.
+	uint32_t channel;
+
+	/// \brief The MIDI note number.
+	uint8_t note;
+
+	/// \brief The MIDI note velocity (0 - 127).
+	uint8_t velocity;
+
+	/// \brief The MIDI control number.
+	uint8_t control;
+
+	/// \brief The MIDI bank select value (MSB).
+	uint8_t bank;
+
+	/// \brief The MIDI program number.
+	uint8_t preset;
+
+	/// \brief Non-zero if the event also changes the value the channel returns to on #DmEvent_RESET.
+	uint8_t reset;
+
+	/// \brief The number of semitones to transpose all subsequent notes on the channel by.
+	int16_t transpose;
+
+	/// \brief The value of the control change, normalized to 0 - 1.
+	float value;
+
+	/// \brief The pitch bend value (0 - 16383, centered at 8192).
+	int bend;
+
+	/// \brief The value the control returns to on #DmEvent_RESET, normalized to 0 - 1.
+	float reset_value;
+
+	/// \brief The pitch bend value the channel returns to on #DmEvent_RESET.
+	int reset_bend;
+} DmEvent;
+
+/// \brief A callback function receiving events from #DmPerformance_renderEvents.
+/// \param ctx The user-defined context pointer passed to #DmPerformance_renderEvents.
+/// \param evt[in] The event. Only valid for the duration of the call.
+typedef void DmEventCallback(void* ctx, DmEvent const* evt);
+
 typedef enum DmTiming {
 	/// \brief Timing flag indicating start at the next possible tick.
 	DmTiming_INSTANT = 1,
@@ -614,6 +1194,43 @@ DMAPI DmResult DmPerformance_playTransition(DmPerformance* slf,
 /// \retval #DmResult_MUTEX_ERROR An error occurred while trying to lock an internal mutex.
 DMAPI DmResult DmPerformance_renderPcm(DmPerformance* slf, void* buf, size_t num, DmRenderOptions opts);
 
+/// \brief Advance a performance by a given number of samples without synthesizing any audio.
+///
+/// This performs exactly the same musical operations as #DmPerformance_renderPcm but, instead of sending notes to
+/// the internal synthesizer, all note, control change, pitch bend and instrument change events are passed to \p cb
+/// in the order they occur. This is useful for driving an external synthesizer or MIDI device and for running
+/// compositions faster than real time, since no DLS instruments are loaded into the synthesizer and no PCM is rendered.
+///
+/// Timing is the same as for mono rendering with #DmPerformance_renderPcm, i.e. \p num is the number of samples at the
+/// sample rate passed to #DmPerformance_create to advance by.
+///
+/// \note The callback is invoked while an internal mutex is held and must not call back into the performance.
+///
+/// \param slf[in] The performance to advance.
+/// \param num The number of samples to advance the performance by.
+/// \param cb A callback to receive all events. May be `NULL`, in which case the performance is advanced silently.
+/// \param ctx An arbitrary pointer passed to \p cb.
+///
+/// \return #DmResult_SUCCESS if the operation completed and an error code if it did not.
+/// \retval #DmResult_INVALID_ARGUMENT \p slf was `NULL`.
+/// \retval #DmResult_MUTEX_ERROR An error occurred while trying to lock an internal mutex.
+DMAPI DmResult DmPerformance_renderEvents(DmPerformance* slf, size_t num, DmEventCallback* cb, void* ctx);
+
+/// \brief Re-seed the random number generator of a performance.
+///
+/// Every performance owns a pseudo-random number generator which is used to select patterns and variations
+/// and to randomize note timing. By default, it is seeded using the generator set by #Dm_setRandomNumberGenerator.
+/// Two performances with the same seed playing the same segments produce the same output, independent of any
+/// other performance rendering at the same time.
+///
+/// \param slf[in] The performance to seed the random number generator of.
+/// \param seed The new seed value.
+///
+/// \return #DmResult_SUCCESS if the operation completed and an error code if it did not.
+/// \retval #DmResult_INVALID_ARGUMENT \p slf was `NULL`.
+/// \retval #DmResult_MUTEX_ERROR An error occurred while trying to lock an internal mutex.
+DMAPI DmResult DmPerformance_setRandomSeed(DmPerformance* slf, uint64_t seed);
+
 /// \brief Set the playback volume of a performance
 /// \note This only affects the output created when calling #DmPerformance_renderPcm.
 /// \param slf[in] The performance to set the volume of.
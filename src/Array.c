@@ -3,11 +3,12 @@
 #include "_Internal.h"
 
 DmArray_IMPLEMENT(DmBandList, DmBand*, DmBand_release(*itm));
-DmArray_IMPLEMENT(DmPartList, DmPart, DmPart_free(itm));
+DmArray_IMPLEMENT(DmPartList, DmPart, );
 DmArray_IMPLEMENT(DmPatternList, DmPattern, DmPattern_free(itm));
 DmArray_IMPLEMENT(DmPartReferenceList, DmPartReference, DmPartReference_free(itm));
-DmArray_IMPLEMENT(DmResolverList, DmResolver, );
-DmArray_IMPLEMENT(DmStyleCache, DmStyle*, DmStyle_release(*itm));
-DmArray_IMPLEMENT(DmDlsCache, DmDls*, DmDls_release(*itm));
 DmArray_IMPLEMENT(DmMessageList, DmMessage, DmMessage_free(itm));
-DmArray_IMPLEMENT(DmSynthFontArray, DmSynthFont, tsf_close(itm->syn));
+DmArray_IMPLEMENT(DmSynthChannelArray, DmSynthChannel, );
+DmArray_IMPLEMENT(DmSynthFontArray, DmSynthFont, DmDls_closeFont(itm->dls, itm->syn); DmDls_release(itm->dls));
+DmArray_IMPLEMENT(DmPartCursorList, DmPartCursor, );
+DmArray_IMPLEMENT(DmLoaderStatsRecordList, DmLoaderStatsRecord, );
+DmArray_IMPLEMENT(DmTransitionCache, DmTransitionCacheEntry, DmSegment_release(itm->transition));
@@ -13,6 +13,13 @@ DmResult DmBand_create(DmBand** slf) {
 	}
 
 	new->reference_count = 1;
+	(void) DmArena_init(&new->arena, 0);
+
+	if (mtx_init(&new->download_lock, mtx_plain) != thrd_success) {
+		Dm_free(new);
+		return DmResult_MUTEX_ERROR;
+	}
+
 	return DmResult_SUCCESS;
 }
 
@@ -40,6 +47,8 @@ void DmBand_release(DmBand* slf) {
 	}
 
 	Dm_free(slf->instruments);
+	DmArena_free(&slf->arena);
+	mtx_destroy(&slf->download_lock);
 	Dm_free(slf);
 }
 
@@ -79,6 +88,10 @@ DmResult DmBand_download(DmBand* slf, DmLoader* loader) {
 		return DmResult_INVALID_ARGUMENT;
 	}
 
+	if (mtx_lock(&slf->download_lock) != thrd_success) {
+		return DmResult_MUTEX_ERROR;
+	}
+
 	Dm_report(DmLogLevel_INFO, "DmBand: Downloading instruments for band '%s'", slf->info.unam);
 
 	DmResult rv = DmResult_SUCCESS;
@@ -99,28 +112,35 @@ DmResult DmBand_download(DmBand* slf, DmLoader* loader) {
 			continue;
 		}
 
+		// Bands are shared between segments, so the reference is copied instead of redirecting the band's own.
+		DmReference reference = instrument->reference;
 		if (instrument->options & DmInstrument_GENERAL_MIDI) {
-			instrument->reference.file = "gm.dls";
+			reference.file = "gm.dls";
 			Dm_report(DmLogLevel_INFO,
 			          "DmBand: Trying to download instrument '%s' from the general MIDI collection (gm.dls)",
 			          instrument->reference.name);
 		} else if (instrument->options & DmInstrument_ROLAND_GS) {
-			instrument->reference.file = "gs.dls";
+			reference.file = "gs.dls";
 			Dm_report(DmLogLevel_INFO,
 			          "DmBand: Trying to download instrument '%s' from the Roland GS collection (gs.dls)",
 			          instrument->reference.name);
 		} else if (instrument->options & DmInstrument_YAMAHA_XG) {
-			instrument->reference.file = "xg.dls";
+			reference.file = "xg.dls";
 			Dm_report(DmLogLevel_INFO,
 			          "DmBand: Trying to download instrument '%s' from the Yamaha XG collection (xg.dls)",
 			          instrument->reference.name);
 		}
 
-		rv = DmLoader_getDownloadableSound(loader, &instrument->reference, &instrument->dls);
-		if (rv != DmResult_SUCCESS || instrument->dls == NULL) {
+		DmDls* dls = NULL;
+		rv = DmLoader_getDownloadableSound(loader, &reference, &dls);
+		if (rv != DmResult_SUCCESS || dls == NULL) {
 			continue;
 		}
 
+		// Synthesizers playing the band might read the instrument concurrently, so it is only published once the
+		// collection has been loaded completely.
+		atomic_store(&instrument->dls, dls);
+
 		DmDlsInstrument* dls_instrument = DmInstrument_getDlsInstrument(instrument);
 		if (dls_instrument == NULL) {
 			continue;
@@ -133,6 +153,7 @@ DmResult DmBand_download(DmBand* slf, DmLoader* loader) {
 		          slf->info.unam);
 	}
 
+	(void) mtx_unlock(&slf->download_lock);
 	return rv;
 }
 
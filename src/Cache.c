@@ -0,0 +1,317 @@
+// Copyright © 2024. GothicKit Contributors
+// SPDX-License-Identifier: MIT-Modern-Variant
+#include "_Internal.h"
+
+#include <ctype.h>
+
+enum {
+	DmInt_CACHE_INITIAL_BUCKETS = 32,
+};
+
+// FNV-1a, see http://www.isthe.com/chongo/tech/comp/fnv/
+static uint64_t DmCache_hashGuid(DmGuid const* guid) {
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	for (size_t i = 0; i < sizeof guid->data; ++i) {
+		hash = (hash ^ guid->data[i]) * 0x100000001B3ULL;
+	}
+	return hash;
+}
+
+uint64_t DmCache_hashData(void const* data, size_t len) {
+	uint8_t const* bytes = data;
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	for (size_t i = 0; i < len; ++i) {
+		hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+	}
+	return hash;
+}
+
+// File names originate from Windows, so they are hashed and compared case-insensitively.
+uint64_t DmCache_hashFile(char const* file) {
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	for (; *file != '\0'; ++file) {
+		hash = (hash ^ (uint8_t) tolower((unsigned char) *file)) * 0x100000001B3ULL;
+	}
+	return hash;
+}
+
+bool DmCache_fileEquals(char const* a, char const* b) {
+	for (; *a != '\0' && *b != '\0'; ++a, ++b) {
+		if (tolower((unsigned char) *a) != tolower((unsigned char) *b)) {
+			return false;
+		}
+	}
+
+	return *a == *b;
+}
+
+static bool DmCache_isNullGuid(DmGuid const* guid) {
+	static DmGuid const null = {{0}};
+	return DmGuid_equals(guid, &null);
+}
+
+DmResult DmCache_init(DmCache* slf, DmCacheRetain* retain, DmCacheRelease* release, DmCacheUnused* unused) {
+	if (slf == NULL) {
+		return DmResult_INVALID_ARGUMENT;
+	}
+
+	slf->retain = retain;
+	slf->release = release;
+	slf->unused = unused;
+	slf->length = 0;
+	slf->size = 0;
+	slf->least_used = NULL;
+	slf->most_used = NULL;
+	slf->bucket_count = DmInt_CACHE_INITIAL_BUCKETS;
+	slf->guid_buckets = Dm_alloc(slf->bucket_count * sizeof *slf->guid_buckets);
+	slf->file_buckets = Dm_alloc(slf->bucket_count * sizeof *slf->file_buckets);
+
+	if (slf->guid_buckets == NULL || slf->file_buckets == NULL) {
+		Dm_free(slf->guid_buckets);
+		Dm_free(slf->file_buckets);
+		return DmResult_MEMORY_EXHAUSTED;
+	}
+
+	return DmResult_SUCCESS;
+}
+
+void DmCache_clear(DmCache* slf) {
+	if (slf == NULL || slf->guid_buckets == NULL) {
+		return;
+	}
+
+	for (size_t i = 0; i < slf->bucket_count; ++i) {
+		DmCacheEntry* entry = slf->guid_buckets[i];
+		while (entry != NULL) {
+			DmCacheEntry* next = entry->next_guid;
+
+			if (entry->object != NULL) {
+				slf->release(entry->object);
+			}
+
+			DmCacheEntry_free(entry);
+			entry = next;
+		}
+
+		slf->guid_buckets[i] = NULL;
+		slf->file_buckets[i] = NULL;
+	}
+
+	slf->length = 0;
+	slf->size = 0;
+	slf->least_used = NULL;
+	slf->most_used = NULL;
+}
+
+void DmCache_free(DmCache* slf) {
+	if (slf == NULL || slf->guid_buckets == NULL) {
+		return;
+	}
+
+	DmCache_clear(slf);
+
+	Dm_free(slf->guid_buckets);
+	Dm_free(slf->file_buckets);
+	slf->guid_buckets = NULL;
+	slf->file_buckets = NULL;
+	slf->bucket_count = 0;
+	slf->length = 0;
+	slf->size = 0;
+}
+
+DmCacheEntry* DmCache_find(DmCache* slf, DmGuid const* guid, char const* file) {
+	if (slf == NULL) {
+		return NULL;
+	}
+
+	if (guid != NULL && !DmCache_isNullGuid(guid)) {
+		size_t bucket = DmCache_hashGuid(guid) % slf->bucket_count;
+		for (DmCacheEntry* entry = slf->guid_buckets[bucket]; entry != NULL; entry = entry->next_guid) {
+			if (DmGuid_equals(&entry->guid, guid)) {
+				return entry;
+			}
+		}
+	}
+
+	if (file != NULL) {
+		size_t bucket = DmCache_hashFile(file) % slf->bucket_count;
+		for (DmCacheEntry* entry = slf->file_buckets[bucket]; entry != NULL; entry = entry->next_file) {
+			if (DmCache_fileEquals(entry->file, file)) {
+				return entry;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+static void DmCache_link(DmCache* slf, DmCacheEntry* entry) {
+	size_t bucket = entry->guid_hash % slf->bucket_count;
+	entry->next_guid = slf->guid_buckets[bucket];
+	slf->guid_buckets[bucket] = entry;
+
+	bucket = entry->file_hash % slf->bucket_count;
+	entry->next_file = slf->file_buckets[bucket];
+	slf->file_buckets[bucket] = entry;
+}
+
+static DmResult DmCache_grow(DmCache* slf) {
+	size_t old_count = slf->bucket_count;
+	DmCacheEntry** old_guid_buckets = slf->guid_buckets;
+	DmCacheEntry** old_file_buckets = slf->file_buckets;
+
+	size_t new_count = old_count * 2;
+	DmCacheEntry** new_guid_buckets = Dm_alloc(new_count * sizeof *new_guid_buckets);
+	DmCacheEntry** new_file_buckets = Dm_alloc(new_count * sizeof *new_file_buckets);
+
+	if (new_guid_buckets == NULL || new_file_buckets == NULL) {
+		Dm_free(new_guid_buckets);
+		Dm_free(new_file_buckets);
+		return DmResult_MEMORY_EXHAUSTED;
+	}
+
+	slf->bucket_count = new_count;
+	slf->guid_buckets = new_guid_buckets;
+	slf->file_buckets = new_file_buckets;
+
+	// Every entry is linked into the GUID index, so walking it re-links all entries.
+	for (size_t i = 0; i < old_count; ++i) {
+		DmCacheEntry* entry = old_guid_buckets[i];
+		while (entry != NULL) {
+			DmCacheEntry* next = entry->next_guid;
+			DmCache_link(slf, entry);
+			entry = next;
+		}
+	}
+
+	Dm_free(old_guid_buckets);
+	Dm_free(old_file_buckets);
+	return DmResult_SUCCESS;
+}
+
+DmResult DmCache_insert(DmCache* slf, DmGuid const* guid, char const* file, DmCacheEntry** out) {
+	if (slf == NULL || guid == NULL || file == NULL || out == NULL) {
+		return DmResult_INVALID_ARGUMENT;
+	}
+
+	// Keep the load factor below 0.75
+	if ((slf->length + 1) * 4 > slf->bucket_count * 3) {
+		DmResult rv = DmCache_grow(slf);
+		if (rv != DmResult_SUCCESS) {
+			return rv;
+		}
+	}
+
+	size_t file_len = strlen(file);
+	DmCacheEntry* entry = Dm_alloc(sizeof *entry + file_len + 1);
+	if (entry == NULL) {
+		return DmResult_MEMORY_EXHAUSTED;
+	}
+
+	entry->prev_used = NULL;
+	entry->next_used = NULL;
+	entry->guid = *guid;
+	entry->guid_hash = DmCache_hashGuid(guid);
+	entry->file = (char*) (entry + 1);
+	entry->file_hash = DmCache_hashFile(file);
+	entry->state = DmCacheState_LOADING;
+	entry->result = DmResult_SUCCESS;
+	entry->waiters = 0;
+	entry->object = NULL;
+	entry->size = 0;
+	entry->last_used = 0;
+	memcpy(entry->file, file, file_len + 1);
+
+	DmCache_link(slf, entry);
+	slf->length += 1;
+
+	*out = entry;
+	return DmResult_SUCCESS;
+}
+
+static void DmCache_unlinkUsed(DmCache* slf, DmCacheEntry* entry) {
+	if (entry->prev_used == NULL && slf->least_used != entry) {
+		return;
+	}
+
+	if (entry->prev_used != NULL) {
+		entry->prev_used->next_used = entry->next_used;
+	} else {
+		slf->least_used = entry->next_used;
+	}
+
+	if (entry->next_used != NULL) {
+		entry->next_used->prev_used = entry->prev_used;
+	} else {
+		slf->most_used = entry->prev_used;
+	}
+
+	entry->prev_used = NULL;
+	entry->next_used = NULL;
+}
+
+// Entries are only added to the list once they are ready, so entries which are still loading are never evicted.
+void DmCache_touch(DmCache* slf, DmCacheEntry* entry) {
+	if (slf == NULL || entry == NULL || slf->most_used == entry) {
+		return;
+	}
+
+	DmCache_unlinkUsed(slf, entry);
+
+	entry->prev_used = slf->most_used;
+	if (slf->most_used != NULL) {
+		slf->most_used->next_used = entry;
+	} else {
+		slf->least_used = entry;
+	}
+	slf->most_used = entry;
+}
+
+void DmCache_remove(DmCache* slf, DmCacheEntry* entry) {
+	if (slf == NULL || entry == NULL) {
+		return;
+	}
+
+	DmCache_unlinkUsed(slf, entry);
+
+	DmCacheEntry** it = &slf->guid_buckets[entry->guid_hash % slf->bucket_count];
+	for (; *it != NULL; it = &(*it)->next_guid) {
+		if (*it == entry) {
+			*it = entry->next_guid;
+			break;
+		}
+	}
+
+	it = &slf->file_buckets[entry->file_hash % slf->bucket_count];
+	for (; *it != NULL; it = &(*it)->next_file) {
+		if (*it == entry) {
+			*it = entry->next_file;
+			break;
+		}
+	}
+
+	entry->next_guid = NULL;
+	entry->next_file = NULL;
+	slf->length -= 1;
+	slf->size -= entry->size;
+}
+
+DmCacheEntry* DmCache_findEvictable(DmCache* slf) {
+	if (slf == NULL) {
+		return NULL;
+	}
+
+	// Objects still referenced outside the cache can't be evicted, since evicting them would not free any memory
+	// and would cause them to be loaded a second time.
+	for (DmCacheEntry* entry = slf->least_used; entry != NULL; entry = entry->next_used) {
+		if (entry->waiters == 0 && slf->unused(entry->object)) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+void DmCacheEntry_free(DmCacheEntry* slf) {
+	Dm_free(slf);
+}
@@ -0,0 +1,39 @@
+// Copyright © 2024. GothicKit Contributors
+// SPDX-License-Identifier: MIT-Modern-Variant
+#include "_Internal.h"
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <time.h>
+#endif
+
+#ifdef _WIN32
+uint64_t Dm_getMonotonicTime(void) {
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+
+	if (!QueryPerformanceFrequency(&frequency) || !QueryPerformanceCounter(&counter)) {
+		return 0;
+	}
+
+	// Split the conversion to avoid overflowing the intermediate product for large counter values.
+	uint64_t seconds = (uint64_t) counter.QuadPart / (uint64_t) frequency.QuadPart;
+	uint64_t remainder = (uint64_t) counter.QuadPart % (uint64_t) frequency.QuadPart;
+	return seconds * 1000000000ULL + remainder * 1000000000ULL / (uint64_t) frequency.QuadPart;
+}
+#else
+uint64_t Dm_getMonotonicTime(void) {
+	struct timespec ts;
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+		return 0;
+	}
+
+	return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+#endif
+
+double Dm_getElapsedSeconds(uint64_t start, uint64_t end) {
+	return end > start ? (double) (end - start) / 1e9 : 0.0;
+}
@@ -15,6 +15,10 @@ size_t max_usize(size_t a, size_t b) {
 	return a >= b ? a : b;
 }
 
+size_t min_usize(size_t a, size_t b) {
+	return a <= b ? a : b;
+}
+
 int32_t max_s32(int32_t a, int32_t b) {
 	return a > b ? a : b;
 }
@@ -39,8 +43,8 @@ int32_t clamp_s32(int32_t val, int32_t min, int32_t max) {
 	return val;
 }
 
-int32_t Dm_randRange(int32_t range) {
-	uint32_t rnd = Dm_rand() % range;
+int32_t Dm_randRange(DmRandom* rng, int32_t range) {
+	uint32_t rnd = DmRandom_next(rng) % range;
 	return range - (int32_t) (rnd / 2);
 }
 
@@ -20,12 +20,12 @@ DmResult Dm_composeTransition(DmStyle* sty,
 	trans->loop_start = 0;
 	trans->loop_end = trans->length;
 	trans->downloaded = true;
-	trans->info.unam = "Composed Transition";
+	strncpy(trans->info.unam, "Composed Transition", sizeof trans->info.unam - 1);
 
 	// NOTE: We only support transitions of length 1 (measure)
 
 	DmMessage msg;
-	msg.time = 0;
+	memset(&msg, 0, sizeof msg);
 
 	if (embellishment != DmEmbellishment_NONE) {
 		msg.type = DmMessage_TEMPO;
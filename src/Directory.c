@@ -0,0 +1,306 @@
+// Copyright © 2024. GothicKit Contributors
+// SPDX-License-Identifier: MIT-Modern-Variant
+#include "_Internal.h"
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <dirent.h>
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+typedef struct DmDirectoryEntry {
+	struct DmDirectoryEntry* next;
+	uint64_t hash;
+	char const* name;
+	char path[];
+} DmDirectoryEntry;
+
+struct DmDirectory {
+	size_t length;
+	size_t bucket_count;
+	DmDirectoryEntry** buckets;
+};
+
+// Entries are first collected into a list and hashed into buckets once the final count is known.
+static DmResult DmDirectory_addEntry(DmDirectoryEntry** list, char const* dir, char const* name) {
+	size_t dir_len = strlen(dir);
+	size_t name_len = strlen(name);
+
+	DmDirectoryEntry* entry = Dm_alloc(sizeof *entry + dir_len + name_len + 2);
+	if (entry == NULL) {
+		return DmResult_MEMORY_EXHAUSTED;
+	}
+
+	memcpy(entry->path, dir, dir_len);
+	entry->path[dir_len] = '/';
+	memcpy(entry->path + dir_len + 1, name, name_len + 1);
+
+	entry->name = entry->path + dir_len + 1;
+	entry->hash = DmCache_hashFile(entry->name);
+	entry->next = *list;
+	*list = entry;
+	return DmResult_SUCCESS;
+}
+
+#ifdef _WIN32
+static DmResult DmDirectory_scan(DmDirectoryEntry** list, char const* path, size_t* count) {
+	char* pattern = Dm_alloc(strlen(path) + 3);
+	if (pattern == NULL) {
+		return DmResult_MEMORY_EXHAUSTED;
+	}
+
+	strcpy(pattern, path);
+	strcat(pattern, "/*");
+
+	WIN32_FIND_DATAA data;
+	HANDLE find = FindFirstFileA(pattern, &data);
+	Dm_free(pattern);
+
+	if (find == INVALID_HANDLE_VALUE) {
+		return DmResult_NOT_FOUND;
+	}
+
+	DmResult rv = DmResult_SUCCESS;
+	do {
+		if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+			continue;
+		}
+
+		rv = DmDirectory_addEntry(list, path, data.cFileName);
+		if (rv != DmResult_SUCCESS) {
+			break;
+		}
+
+		*count += 1;
+	} while (FindNextFileA(find, &data));
+
+	FindClose(find);
+	return rv;
+}
+
+void Dm_unmapFile(void* ctx, void* buf, size_t len) {
+	(void) ctx;
+	(void) len;
+
+	if (buf != NULL) {
+		UnmapViewOfFile(buf);
+	}
+}
+
+void* Dm_mapFile(char const* path, size_t* len) {
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return NULL;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0 || (uint64_t) size.QuadPart > SIZE_MAX) {
+		CloseHandle(file);
+		return NULL;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+
+	if (mapping == NULL) {
+		return NULL;
+	}
+
+	// The view keeps the mapping alive, so both handles can be closed right away.
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+
+	*len = (size_t) size.QuadPart;
+	return view;
+}
+#else
+static DmResult DmDirectory_scan(DmDirectoryEntry** list, char const* path, size_t* count) {
+	DIR* dir = opendir(path);
+	if (dir == NULL) {
+		return DmResult_NOT_FOUND;
+	}
+
+	DmResult rv = DmResult_SUCCESS;
+	struct dirent* ent = NULL;
+	while ((ent = readdir(dir)) != NULL) {
+		if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) {
+			continue;
+		}
+
+		rv = DmDirectory_addEntry(list, path, ent->d_name);
+		if (rv != DmResult_SUCCESS) {
+			break;
+		}
+
+		*count += 1;
+	}
+
+	closedir(dir);
+	return rv;
+}
+
+void Dm_unmapFile(void* ctx, void* buf, size_t len) {
+	(void) ctx;
+
+	if (buf != NULL) {
+		(void) munmap(buf, len);
+	}
+}
+
+void* Dm_mapFile(char const* path, size_t* len) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return NULL;
+	}
+
+	// Sub-directories are not filtered while scanning, so they are rejected here.
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+		(void) close(fd);
+		return NULL;
+	}
+
+	// The mapping stays valid after the file descriptor is closed.
+	void* view = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	(void) close(fd);
+
+	if (view == MAP_FAILED) {
+		return NULL;
+	}
+
+	*len = (size_t) st.st_size;
+	return view;
+}
+#endif
+
+DmResult DmDirectory_open(DmDirectory** slf, char const* path) {
+	if (slf == NULL || path == NULL) {
+		return DmResult_INVALID_ARGUMENT;
+	}
+
+	DmDirectoryEntry* list = NULL;
+	size_t count = 0;
+
+	DmResult rv = DmDirectory_scan(&list, path, &count);
+	if (rv == DmResult_SUCCESS) {
+		rv = DmResult_MEMORY_EXHAUSTED;
+
+		DmDirectory* new = *slf = Dm_alloc(sizeof *new);
+		if (new != NULL) {
+			// Keep the load factor at or below 0.5
+			new->length = count;
+			new->bucket_count = 16;
+			while (new->bucket_count < count * 2) {
+				new->bucket_count *= 2;
+			}
+
+			new->buckets = Dm_alloc(new->bucket_count * sizeof *new->buckets);
+			if (new->buckets != NULL) {
+				rv = DmResult_SUCCESS;
+			} else {
+				Dm_free(new);
+				*slf = NULL;
+			}
+		}
+	}
+
+	while (list != NULL) {
+		DmDirectoryEntry* entry = list;
+		list = entry->next;
+
+		if (rv != DmResult_SUCCESS) {
+			Dm_free(entry);
+			continue;
+		}
+
+		size_t bucket = entry->hash & ((*slf)->bucket_count - 1);
+		entry->next = (*slf)->buckets[bucket];
+		(*slf)->buckets[bucket] = entry;
+	}
+
+	if (rv == DmResult_SUCCESS) {
+		Dm_report(DmLogLevel_DEBUG, "DmDirectory: Indexed %zu files in '%s'", count, path);
+	}
+
+	return rv;
+}
+
+void DmDirectory_close(void* ctx) {
+	DmDirectory* slf = ctx;
+	if (slf == NULL) {
+		return;
+	}
+
+	for (size_t i = 0; i < slf->bucket_count; ++i) {
+		DmDirectoryEntry* entry = slf->buckets[i];
+		while (entry != NULL) {
+			DmDirectoryEntry* next = entry->next;
+			Dm_free(entry);
+			entry = next;
+		}
+	}
+
+	Dm_free(slf->buckets);
+	Dm_free(slf);
+}
+
+void* DmDirectory_resolve(void* ctx,
+                          char const* file,
+                          size_t* len,
+                          DmLoaderBufferRelease** release,
+                          void** release_ctx) {
+	DmDirectory* slf = ctx;
+	if (slf == NULL || file == NULL) {
+		return NULL;
+	}
+
+	// The index is flat, so only the last component of the requested path is considered.
+	for (char const* it = file; *it != '\0'; ++it) {
+		if (*it == '/' || *it == '\\') {
+			file = it + 1;
+		}
+	}
+
+	uint64_t hash = DmCache_hashFile(file);
+	DmDirectoryEntry* entry = slf->buckets[hash & (slf->bucket_count - 1)];
+	for (; entry != NULL; entry = entry->next) {
+		if (entry->hash == hash && DmCache_fileEquals(entry->name, file)) {
+			break;
+		}
+	}
+
+	if (entry == NULL) {
+		return NULL;
+	}
+
+	void* buf = Dm_mapFile(entry->path, len);
+	if (buf == NULL) {
+		Dm_report(DmLogLevel_WARN, "DmDirectory: Failed to map '%s'", entry->path);
+		return NULL;
+	}
+
+	*release = Dm_unmapFile;
+	*release_ctx = NULL;
+	return buf;
+}
+
+size_t DmDirectory_getFileCount(DmDirectory* slf) {
+	return slf == NULL ? 0 : slf->length;
+}
+
+void DmDirectory_visit(DmDirectory* slf, DmDirectoryVisitor* visit, void* ctx) {
+	if (slf == NULL || visit == NULL) {
+		return;
+	}
+
+	for (size_t i = 0; i < slf->bucket_count; ++i) {
+		for (DmDirectoryEntry* entry = slf->buckets[i]; entry != NULL; entry = entry->next) {
+			visit(ctx, entry->name, entry->path);
+		}
+	}
+}
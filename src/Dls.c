@@ -2,6 +2,16 @@
 // SPDX-License-Identifier: MIT-Modern-Variant
 #include "_Internal.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define DM_HAS_SSE2
+#endif
+
+// Wave data is not necessarily aligned, so samples are assembled byte by byte.
+static int16_t DmDls_readShort(uint8_t const* buf) {
+	return (int16_t) (uint16_t) (buf[0] | buf[1] << 8);
+}
+
 DmResult DmDls_create(DmDls** slf) {
 	if (slf == NULL) {
 		return DmResult_INVALID_ARGUMENT;
@@ -13,6 +23,12 @@ DmResult DmDls_create(DmDls** slf) {
 	}
 
 	new->reference_count = 1;
+
+	if (mtx_init(&new->font_lock, mtx_plain) != thrd_success) {
+		Dm_free(new);
+		return DmResult_MUTEX_ERROR;
+	}
+
 	return DmResult_SUCCESS;
 }
 
@@ -35,14 +51,28 @@ size_t DmDls_release(DmDls* slf) {
 		return refs;
 	}
 
-	for (uint32_t i = 0; i < slf->instrument_count; ++i) {
-		DmDlsInstrument_free(&slf->instruments[i]);
+	// Only collections evicted from a loader's cache are freed while still counted by it.
+	if (slf->font_memory != NULL) {
+		(void) atomic_fetch_sub(slf->font_memory, slf->font_size);
 	}
 
+	DmArena_free(&slf->arena);
 	Dm_free(slf->instruments);
 	Dm_free(slf->pool_table);
 	Dm_free(slf->wave_table);
-	Dm_free(slf->backing_memory);
+	// Samples of cached and streamed fonts are not owned by the font, so they must not be freed by TinySoundFont.
+	if (slf->font != NULL && (slf->font_mapping != NULL || slf->font_samples != NULL)) {
+		slf->font->fontSamples = NULL;
+	}
+
+	tsf_close(slf->font);
+	Dm_unmapFile(NULL, slf->font_mapping, slf->font_mapping_length);
+	Dm_releaseMemory(slf->font_samples, slf->font_samples_length);
+	Dm_free(slf->wave_offsets);
+	Dm_free(slf->wave_decoded);
+	Dm_free(slf->font_cache_path);
+	mtx_destroy(&slf->font_lock);
+	Dm_releaseBuffer(slf->backing_memory, slf->backing_length, slf->backing_release, slf->backing_context);
 	Dm_free(slf);
 	return 0;
 }
@@ -55,28 +85,6 @@ void DmDlsInstrument_init(DmDlsInstrument* slf) {
 	memset(slf, 0, sizeof *slf);
 }
 
-void DmDlsInstrument_free(DmDlsInstrument* slf) {
-	if (slf == NULL) {
-		return;
-	}
-
-	for (size_t i = 0; i < slf->region_count; ++i) {
-		DmDlsRegion_free(&slf->regions[i]);
-	}
-
-	Dm_free(slf->regions);
-	slf->regions = NULL;
-	slf->region_count = 0;
-
-	for (size_t i = 0; i < slf->articulator_count; ++i) {
-		DmDlsArticulator_free(&slf->articulators[i]);
-	}
-
-	Dm_free(slf->articulators);
-	slf->articulators = NULL;
-	slf->articulator_count = 0;
-}
-
 void DmDlsRegion_init(DmDlsRegion* slf) {
 	if (slf == NULL) {
 		return;
@@ -85,20 +93,6 @@ void DmDlsRegion_init(DmDlsRegion* slf) {
 	memset(slf, 0, sizeof *slf);
 }
 
-void DmDlsRegion_free(DmDlsRegion* slf) {
-	if (slf == NULL) {
-		return;
-	}
-
-	for (size_t i = 0; i < slf->articulator_count; ++i) {
-		DmDlsArticulator_free(&slf->articulators[i]);
-	}
-
-	Dm_free(slf->articulators);
-	slf->articulators = NULL;
-	slf->articulator_count = 0;
-}
-
 void DmDlsArticulator_init(DmDlsArticulator* slf) {
 	if (slf == NULL) {
 		return;
@@ -107,26 +101,33 @@ void DmDlsArticulator_init(DmDlsArticulator* slf) {
 	memset(slf, 0, sizeof *slf);
 }
 
-void DmDlsArticulator_free(DmDlsArticulator* slf) {
-	if (slf == NULL) {
-		return;
-	}
-
-	Dm_free(slf->connections);
-	slf->connections = NULL;
-	slf->connection_count = 0;
-}
-
+// Divides instead of multiplying by the reciprocal so that both paths produce exactly the same samples.
 static size_t DmDlsWave_decodeShort(DmDlsWave const* slf, float* out, size_t len) {
 	uint32_t size = slf->pcm_size / 2;
 	if (out == NULL) {
 		return size;
 	}
 
-	int16_t const* raw = (int16_t const*) slf->pcm;
+	uint8_t const* raw = slf->pcm;
+	size_t count = min_usize(size, len);
 	size_t i = 0;
-	for (i = 0; i < size && i < len; ++i) {
-		out[i] = (float) raw[i] / INT16_MAX;
+
+#ifdef DM_HAS_SSE2
+	__m128 const scale = _mm_set1_ps((float) INT16_MAX);
+	for (; i + 8 <= count; i += 8) {
+		__m128i pcm = _mm_loadu_si128((__m128i const*) (raw + i * 2));
+
+		// Sign-extend to 32 bits by moving each sample into the upper half and shifting it back down.
+		__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(pcm, pcm), 16);
+		__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(pcm, pcm), 16);
+
+		_mm_storeu_ps(out + i, _mm_div_ps(_mm_cvtepi32_ps(lo), scale));
+		_mm_storeu_ps(out + i + 4, _mm_div_ps(_mm_cvtepi32_ps(hi), scale));
+	}
+#endif
+
+	for (; i < count; ++i) {
+		out[i] = (float) DmDls_readShort(raw + i * 2) / INT16_MAX;
 	}
 
 	return i;
@@ -152,58 +153,45 @@ static int clamp_16bit(int v) {
 //  				 to this table by including them as metadata chunks in the WAVE header
 static int16_t ADPCM_ADAPT_TABLE[16] = {230, 230, 230, 230, 307, 409, 512, 614, 768, 614, 512, 409, 307, 230, 230, 230};
 
-#define DmInt_read(src, tgt)                                                                                           \
-	memcpy((tgt), (src), sizeof(*(tgt)));                                                                              \
-	(src) += sizeof(*(tgt))
-
 // See https://wiki.multimedia.cx/index.php/Microsoft_ADPCM
-static uint8_t const* DmDls_decodeAdpcmBlock(uint8_t const* adpcm, float* pcm, uint32_t block_size, int16_t const* coeff1, int16_t const* coeff2) {
-	uint8_t block_predictor;
-	DmInt_read(adpcm, &block_predictor);
-
-	int16_t delta_;
-	DmInt_read(adpcm, &delta_);
-	int delta = delta_;
-
-	int16_t sample_a;
-	DmInt_read(adpcm, &sample_a);
+static void DmDls_decodeAdpcmBlock(DmDlsWave const* wav, uint8_t const* adpcm, float* pcm) {
+	// Predictors outside the built-in table are invalid; fall back to the first one instead of reading past it.
+	uint8_t block_predictor = adpcm[0];
+	if (block_predictor >= 7) {
+		block_predictor = 0;
+	}
 
-	int16_t sample_b;
-	DmInt_read(adpcm, &sample_b);
+	int coeff_1 = wav->coefficient_table_0[block_predictor];
+	int coeff_2 = wav->coefficient_table_1[block_predictor];
+	int delta = DmDls_readShort(adpcm + 1);
+	int16_t sample_a = DmDls_readShort(adpcm + 3);
+	int16_t sample_b = DmDls_readShort(adpcm + 5);
 
 	*pcm++ = (float) sample_b / (float) INT16_MAX;
 	*pcm++ = (float) sample_a / (float) INT16_MAX;
 
-	int coeff_1 = coeff1[block_predictor];
-	int coeff_2 = coeff2[block_predictor];
-
-	uint32_t remaining = block_size - 7 /* header */;
-	for (uint32_t i = 0; i < remaining; ++i) {
-		int8_t b;
-		DmInt_read(adpcm, &b);
+	uint8_t const* end = adpcm + wav->block_align;
+	for (adpcm += 7 /* header */; adpcm < end; ++adpcm) {
+		uint8_t b = *adpcm;
 
 		// High Nibble
-		int nibble = signed_4bit((b & 0xF0) >> 4);
 		int predictor = (coeff_1 * sample_a + coeff_2 * sample_b) / 256;
-		predictor += nibble * delta;
+		predictor += signed_4bit(b >> 4) * delta;
 		predictor = clamp_16bit(predictor);
 		*pcm++ = (float) predictor / (float) INT16_MAX;
 		sample_b = sample_a;
 		sample_a = (int16_t) (predictor);
-		delta = max_s32((ADPCM_ADAPT_TABLE[(b & 0xF0) >> 4] * delta) / 256, 16);
+		delta = max_s32((ADPCM_ADAPT_TABLE[b >> 4] * delta) / 256, 16);
 
 		// Low Nibble
-		nibble = signed_4bit((b & 0x0F) >> 0);
 		predictor = (coeff_1 * sample_a + coeff_2 * sample_b) / 256;
-		predictor += nibble * delta;
+		predictor += signed_4bit(b & 0x0F) * delta;
 		predictor = clamp_16bit(predictor);
 		*pcm++ = (float) predictor / (float) INT16_MAX;
 		sample_b = sample_a;
 		sample_a = (int16_t) (predictor);
 		delta = max_s32((ADPCM_ADAPT_TABLE[b & 0x0F] * delta) / 256, 16);
 	}
-
-	return adpcm;
 }
 
 static size_t DmDls_decodeAdpcm(DmDlsWave const* slf, float* out, size_t len) {
@@ -214,6 +202,12 @@ static size_t DmDls_decodeAdpcm(DmDlsWave const* slf, float* out, size_t len) {
 		return 0;
 	}
 
+	// Every block starts with a 7 byte header.
+	if (slf->block_align < 7) {
+		Dm_report(DmLogLevel_ERROR, "DmDls: Invalid ADPCM block size %d", slf->block_align);
+		return 0;
+	}
+
 	uint32_t block_count = slf->pcm_size / slf->block_align;
 	uint32_t frames_per_block =
 	    (uint32_t) (slf->block_align - 6 * slf->channels) * 2 /* two frames per channel from the header */;
@@ -223,18 +217,14 @@ static size_t DmDls_decodeAdpcm(DmDlsWave const* slf, float* out, size_t len) {
 		return size;
 	}
 
-	uint8_t const* adpcm = slf->pcm;
-	size_t offset = 0;
+	// Every block starts with its own predictor state, so blocks are decoded independently of each other. Only whole
+	// blocks are decoded.
+	block_count = (uint32_t) min_usize(block_count, len / frames_per_block);
 	for (size_t i = 0; i < block_count; ++i) {
-		if (len < offset + frames_per_block) {
-			break;
-		}
-
-		adpcm = DmDls_decodeAdpcmBlock(adpcm, out + offset, slf->block_align, slf->coefficient_table_0 , slf->coefficient_table_1);
-		offset += frames_per_block;
+		DmDls_decodeAdpcmBlock(slf, slf->pcm + i * slf->block_align, out + i * frames_per_block);
 	}
 
-	return offset;
+	return (size_t) block_count * frames_per_block;
 }
 
 size_t DmDls_decodeSamples(DmDlsWave const* slf, float* out, size_t len) {
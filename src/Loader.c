@@ -2,7 +2,77 @@
 // SPDX-License-Identifier: MIT-Modern-Variant
 #include "_Internal.h"
 
-static void* DmLoader_resolveName(DmLoader* slf, char const* name, size_t* length);
+#include <stdio.h>
+
+enum {
+	DmInt_LOADER_WORKER_COUNT = 4,
+
+	// The hexadecimal GUID and content hash of a band, see DmLoader_getBandKey.
+	DmInt_LOADER_BAND_KEY_LENGTH = 32 + 16 + 1,
+
+	DmInt_LOADER_STATS_INITIAL_BUCKETS = 32,
+};
+
+// A buffer returned by a resolver.
+typedef struct DmLoaderBuffer {
+	void* data;
+	size_t length;
+	DmLoaderBufferRelease* release;
+	void* context;
+} DmLoaderBuffer;
+
+typedef DmResult DmLoaderParse(DmLoader* slf, DmLoaderBuffer* buf, void** out);
+
+static bool DmLoader_resolveName(DmLoader* slf, char const* name, DmLoaderBuffer* buf);
+static void DmResolverList_release(DmResolverList* slf);
+static DmResult DmLoader_parseMeasured(DmLoader* slf,
+                                       DmLoaderAssetType type,
+                                       char const* name,
+                                       DmLoaderParse* parse,
+                                       DmLoaderBuffer* buf,
+                                       uint64_t resolve_start,
+                                       void** out);
+
+static void* DmLoader_retainDls(void* obj) {
+	return DmDls_retain(obj);
+}
+
+static void DmLoader_releaseDls(void* obj) {
+	(void) DmDls_release(obj);
+}
+
+static void* DmLoader_retainStyle(void* obj) {
+	return DmStyle_retain(obj);
+}
+
+static void DmLoader_releaseStyle(void* obj) {
+	DmStyle_release(obj);
+}
+
+// Objects are only ever retained through the cache while the loader's lock is held, so once the cache holds
+// the last reference, no other thread can obtain a new one while the lock is held.
+static bool DmLoader_isDlsUnused(void* obj) {
+	DmDls* dls = obj;
+	return atomic_load(&dls->reference_count) == 1;
+}
+
+static bool DmLoader_isStyleUnused(void* obj) {
+	DmStyle* sty = obj;
+	return atomic_load(&sty->reference_count) == 1;
+}
+
+static void* DmLoader_retainBand(void* obj) {
+	return DmBand_retain(obj);
+}
+
+static void DmLoader_releaseBand(void* obj) {
+	DmBand_release(obj);
+}
+
+static bool DmLoader_isBandUnused(void* obj) {
+	DmBand* band = obj;
+	return atomic_load(&band->reference_count) == 1;
+}
 
 DmResult DmLoader_create(DmLoader** slf, DmLoaderOptions opt) {
 	if (slf == NULL) {
@@ -17,15 +87,44 @@ DmResult DmLoader_create(DmLoader** slf, DmLoaderOptions opt) {
 
 	new->reference_count = 1;
 	new->autodownload = opt& DmLoader_DOWNLOAD;
+	new->stream = opt & DmLoader_STREAM;
+	DmLoaderStatsRecordList_init(&new->stats);
 
-	if (mtx_init(&new->lock, mtx_recursive) != thrd_success) {
+	if (mtx_init(&new->lock, mtx_plain) != thrd_success) {
 		Dm_free(new);
 		return DmResult_MUTEX_ERROR;
 	}
 
-	DmResolverList_init(&new->resolvers);
-	DmStyleCache_init(&new->style_cache);
-	DmDlsCache_init(&new->dls_cache);
+	if (cnd_init(&new->loaded) != thrd_success) {
+		mtx_destroy(&new->lock);
+		Dm_free(new);
+		return DmResult_MUTEX_ERROR;
+	}
+
+	DmResult rv = DmCache_init(&new->style_cache, DmLoader_retainStyle, DmLoader_releaseStyle, DmLoader_isStyleUnused);
+	if (rv != DmResult_SUCCESS) {
+		DmLoader_release(new);
+		return rv;
+	}
+
+	rv = DmCache_init(&new->dls_cache, DmLoader_retainDls, DmLoader_releaseDls, DmLoader_isDlsUnused);
+	if (rv != DmResult_SUCCESS) {
+		DmLoader_release(new);
+		return rv;
+	}
+
+	rv = DmCache_init(&new->band_cache, DmLoader_retainBand, DmLoader_releaseBand, DmLoader_isBandUnused);
+	if (rv != DmResult_SUCCESS) {
+		DmLoader_release(new);
+		return rv;
+	}
+
+	// Entries in this cache don't have an object. They only record the names of files which were not found.
+	rv = DmCache_init(&new->missing, NULL, NULL, NULL);
+	if (rv != DmResult_SUCCESS) {
+		DmLoader_release(new);
+		return rv;
+	}
 
 	return DmResult_SUCCESS;
 }
@@ -49,209 +148,1347 @@ void DmLoader_release(DmLoader* slf) {
 		return;
 	}
 
+	// Wait for all outstanding asynchronous loads to finish.
+	DmWorkerPool_destroy(slf->workers);
+
+	// Collections might outlive the loader, so they must stop counting their font memory towards it.
+	for (DmCacheEntry* entry = slf->dls_cache.least_used; entry != NULL; entry = entry->next_used) {
+		DmDls_detachFontMemory(entry->object);
+	}
+
 	mtx_destroy(&slf->lock);
-	DmStyleCache_free(&slf->style_cache);
-	DmDlsCache_free(&slf->dls_cache);
-	DmResolverList_free(&slf->resolvers);
+	cnd_destroy(&slf->loaded);
+	DmCache_free(&slf->band_cache);
+	DmCache_free(&slf->style_cache);
+	DmCache_free(&slf->dls_cache);
+	DmCache_free(&slf->missing);
+
+	// Objects released above may still reference buffers returned by resolvers owned by the loader, so they are
+	// only destroyed after the caches have been freed.
+	for (size_t i = 0; slf->resolvers != NULL && i < slf->resolvers->length; ++i) {
+		DmResolver* resolver = &slf->resolvers->data[i];
+		if (resolver->destroy != NULL) {
+			resolver->destroy(resolver->context);
+		}
+
+		Dm_free(resolver->counters);
+	}
+
+	DmResolverList_release(slf->resolvers);
+	DmLoaderStatsRecordList_free(&slf->stats);
+	Dm_free(slf->stats_buckets);
+	Dm_free(slf->font_cache_directory);
 	Dm_free(slf);
 }
 
-DmResult DmLoader_addResolver(DmLoader* slf, DmLoaderResolverCallback* resolve, void* ctx) {
-	if (slf == NULL || resolve == NULL) {
-		return DmResult_INVALID_ARGUMENT;
+static DmResolverList* DmResolverList_retain(DmResolverList* slf) {
+	if (slf == NULL) {
+		return NULL;
 	}
 
-	DmResolver resolver;
-	resolver.context = ctx;
-	resolver.resolve = resolve;
+	(void) atomic_fetch_add(&slf->reference_count, 1);
+	return slf;
+}
 
-	if (mtx_lock(&slf->lock) != thrd_success) {
-		return DmResult_MUTEX_ERROR;
+static void DmResolverList_release(DmResolverList* slf) {
+	if (slf == NULL) {
+		return;
 	}
 
-	DmResult rv = DmResolverList_add(&slf->resolvers, resolver);
+	size_t refs = atomic_fetch_sub(&slf->reference_count, 1) - 1;
+	if (refs != 0) {
+		return;
+	}
 
-	(void) mtx_unlock(&slf->lock);
-	return rv;
+	Dm_free(slf);
 }
 
-void* DmLoader_resolveName(DmLoader* slf, const char* name, size_t* length) {
+static DmResult DmLoader_appendResolver(DmLoader* slf, DmResolver resolver) {
+	// The counters are shared by all copies of the resolver list, so they are allocated separately.
+	resolver.counters = Dm_alloc(sizeof *resolver.counters);
+	if (resolver.counters == NULL) {
+		return DmResult_MEMORY_EXHAUSTED;
+	}
+
 	if (mtx_lock(&slf->lock) != thrd_success) {
-		return NULL;
+		Dm_free(resolver.counters);
+		return DmResult_MUTEX_ERROR;
 	}
 
-	void* bytes = NULL;
-	for (size_t i = 0U; i < slf->resolvers.length; ++i) {
-		DmResolver* resolver = &slf->resolvers.data[i];
-		bytes = resolver->resolve(resolver->context, name, length);
-		if (bytes != NULL) {
-			break;
-		}
+	// Copy the current list of resolvers and append the new one. Threads which are currently resolving a file keep
+	// using the old list until they're done.
+	DmResolverList* old = slf->resolvers;
+	size_t old_length = old != NULL ? old->length : 0;
+
+	DmResolverList* new = Dm_alloc(sizeof *new + (old_length + 1) * sizeof *new->data);
+	if (new == NULL) {
+		(void) mtx_unlock(&slf->lock);
+		Dm_free(resolver.counters);
+		return DmResult_MEMORY_EXHAUSTED;
+	}
+
+	new->reference_count = 1;
+	new->length = old_length + 1;
+
+	if (old != NULL) {
+		memcpy(new->data, old->data, old_length * sizeof *new->data);
 	}
 
+	new->data[old_length] = resolver;
+	slf->resolvers = new;
+
+	// The new resolver might be able to find files which were missing before.
+	DmCache_clear(&slf->missing);
+
 	(void) mtx_unlock(&slf->lock);
-	return bytes;
+
+	DmResolverList_release(old);
+	return DmResult_SUCCESS;
 }
 
-DmResult DmLoader_getSegment(DmLoader* slf, char const* name, DmSegment** segment) {
-	if (slf == NULL || name == NULL || segment == NULL) {
+DmResult DmLoader_addResolver(DmLoader* slf, DmLoaderResolverCallback* resolve, void* ctx) {
+	if (slf == NULL || resolve == NULL) {
 		return DmResult_INVALID_ARGUMENT;
 	}
 
-	size_t length = 0;
-	void* bytes = DmLoader_resolveName(slf, name, &length);
-	if (bytes == NULL) {
-		Dm_report(DmLogLevel_DEBUG, "DmLoader: Segment '%s' not found", name);
-		return DmResult_NOT_FOUND;
+	DmResolver resolver;
+	resolver.context = ctx;
+	resolver.resolve = resolve;
+	resolver.resolve_buffer = NULL;
+	resolver.destroy = NULL;
+
+	return DmLoader_appendResolver(slf, resolver);
+}
+
+DmResult DmLoader_addBufferResolver(DmLoader* slf, DmLoaderBufferResolverCallback* resolve, void* ctx) {
+	if (slf == NULL || resolve == NULL) {
+		return DmResult_INVALID_ARGUMENT;
+	}
+
+	DmResolver resolver;
+	resolver.context = ctx;
+	resolver.resolve = NULL;
+	resolver.resolve_buffer = resolve;
+	resolver.destroy = NULL;
+
+	return DmLoader_appendResolver(slf, resolver);
+}
+
+DmResult DmLoader_addDirectoryResolver(DmLoader* slf, char const* path) {
+	if (slf == NULL || path == NULL) {
+		return DmResult_INVALID_ARGUMENT;
 	}
 
-	DmResult rv = DmSegment_create(segment);
+	DmDirectory* dir = NULL;
+	DmResult rv = DmDirectory_open(&dir, path);
 	if (rv != DmResult_SUCCESS) {
-		Dm_free(bytes);
+		Dm_report(DmLogLevel_ERROR, "DmLoader: Failed to open directory '%s'", path);
 		return rv;
 	}
 
-	Dm_report(DmLogLevel_DEBUG, "DmLoader: Loading segment '%s'", name);
+	DmResolver resolver;
+	resolver.context = dir;
+	resolver.resolve = NULL;
+	resolver.resolve_buffer = DmDirectory_resolve;
+	resolver.destroy = DmDirectory_close;
 
-	rv = DmSegment_parse(*segment, bytes, length);
+	rv = DmLoader_appendResolver(slf, resolver);
 	if (rv != DmResult_SUCCESS) {
-		DmSegment_release(*segment);
-		return rv;
+		DmDirectory_close(dir);
 	}
 
-	if (!slf->autodownload) {
-		return DmResult_SUCCESS;
+	return rv;
+}
+
+DmResult DmLoader_addPackResolver(DmLoader* slf, char const* path) {
+	if (slf == NULL || path == NULL) {
+		return DmResult_INVALID_ARGUMENT;
 	}
 
-	rv = DmSegment_download(*segment, slf);
+	DmPack* pack = NULL;
+	DmResult rv = DmPack_open(&pack, path);
 	if (rv != DmResult_SUCCESS) {
-		Dm_report(DmLogLevel_ERROR, "DmLoader: Automatic download of segment '%s' failed", name);
-		DmSegment_release(*segment);
+		Dm_report(DmLogLevel_ERROR, "DmLoader: Failed to open pack file '%s'", path);
 		return rv;
 	}
 
-	Dm_report(DmLogLevel_INFO, "DmLoader: Automatic download of segment '%s' succeeded", name);
-	return DmResult_SUCCESS;
+	DmResolver resolver;
+	resolver.context = pack;
+	resolver.resolve = NULL;
+	resolver.resolve_buffer = DmPack_resolve;
+	resolver.destroy = DmPack_release;
+
+	rv = DmLoader_appendResolver(slf, resolver);
+	if (rv != DmResult_SUCCESS) {
+		DmPack_release(pack);
+	}
+
+	return rv;
 }
 
-DmResult DmLoader_getDownloadableSound(DmLoader* slf, DmReference const* ref, DmDls** snd) {
-	if (slf == NULL || ref == NULL || snd == NULL) {
-		return DmResult_INVALID_ARGUMENT;
+static bool DmLoader_resolveName(DmLoader* slf, const char* name, DmLoaderBuffer* buf) {
+	buf->data = NULL;
+	buf->length = 0;
+	buf->release = NULL;
+	buf->context = NULL;
+
+	// Only hold the lock while taking a reference to the resolver list. This allows multiple
+	// threads to read files concurrently.
+	if (mtx_lock(&slf->lock) != thrd_success) {
+		return false;
 	}
 
-	// If no file reference is provided, we're unable to load this.
-	if (ref->file == NULL) {
-		return DmResult_NOT_FOUND;
+	// Don't ask the resolvers about files which none of them could find before.
+	if (DmCache_find(&slf->missing, NULL, name) != NULL) {
+		slf->missing_hits += 1;
+		(void) mtx_unlock(&slf->lock);
+		return false;
 	}
 
-	// See if we have the requested item in the cache.
-	if (mtx_lock(&slf->lock) != thrd_success) {
-		return DmResult_MUTEX_ERROR;
+	DmResolverList* resolvers = DmResolverList_retain(slf->resolvers);
+
+	(void) mtx_unlock(&slf->lock);
+
+	if (resolvers == NULL) {
+		return false;
 	}
 
-	for (size_t i = 0; i < slf->dls_cache.length; ++i) {
-		if (!DmGuid_equals(&ref->guid, &slf->dls_cache.data[i]->guid)) {
-			continue;
+	for (size_t i = 0U; i < resolvers->length; ++i) {
+		DmResolver* resolver = &resolvers->data[i];
+
+		if (resolver->resolve_buffer != NULL) {
+			buf->data = resolver->resolve_buffer(resolver->context, name, &buf->length, &buf->release, &buf->context);
+		} else {
+			buf->data = resolver->resolve(resolver->context, name, &buf->length);
 		}
 
-		*snd = DmDls_retain(slf->dls_cache.data[i]);
+		if (buf->data != NULL) {
+			(void) atomic_fetch_add(&resolver->counters->hits, 1);
+			break;
+		}
 
-		(void) mtx_unlock(&slf->lock);
-		return DmResult_SUCCESS;
+		(void) atomic_fetch_add(&resolver->counters->misses, 1);
+		buf->release = NULL;
+		buf->context = NULL;
 	}
 
-	(void) mtx_unlock(&slf->lock);
+	// Remember that the file is missing. If a resolver was added in the meantime, it might be able to find the file
+	// though, so the miss is only recorded if the list of resolvers has not changed.
+	if (buf->data == NULL && mtx_lock(&slf->lock) == thrd_success) {
+		static DmGuid const null = {{0}};
+		DmCacheEntry* entry = NULL;
 
-	// Resolve and parse the DLS
-	size_t length = 0;
-	void* bytes = DmLoader_resolveName(slf, ref->file, &length);
-	if (bytes == NULL) {
-		Dm_report(DmLogLevel_DEBUG, "DmLoader: DLS collection '%s' not found", ref->name);
-		return DmResult_NOT_FOUND;
-	}
+		if (slf->resolvers == resolvers && DmCache_find(&slf->missing, NULL, name) == NULL &&
+		    DmCache_insert(&slf->missing, &null, name, &entry) == DmResult_SUCCESS) {
+			entry->state = DmCacheState_READY;
+		}
 
-	DmResult rv = DmDls_create(snd);
-	if (rv != DmResult_SUCCESS) {
-		Dm_free(bytes);
-		return rv;
+		(void) mtx_unlock(&slf->lock);
 	}
 
-	Dm_report(DmLogLevel_DEBUG, "DmLoader: Loading DLS collection '%s'", ref->file);
+	DmResolverList_release(resolvers);
+	return buf->data != NULL;
+}
 
-	rv = DmDls_parse(*snd, bytes, length);
-	if (rv != DmResult_SUCCESS) {
-		DmDls_release(*snd);
-		return rv;
+DmResult DmLoader_invalidateMissing(DmLoader* slf, char const* name) {
+	if (slf == NULL) {
+		return DmResult_INVALID_ARGUMENT;
 	}
 
-	// Add the new item to the cache
 	if (mtx_lock(&slf->lock) != thrd_success) {
 		return DmResult_MUTEX_ERROR;
 	}
 
-	rv = DmDlsCache_add(&slf->dls_cache, DmDls_retain(*snd));
+	if (name == NULL) {
+		DmCache_clear(&slf->missing);
+	} else {
+		DmCacheEntry* entry = DmCache_find(&slf->missing, NULL, name);
+		if (entry != NULL) {
+			DmCache_remove(&slf->missing, entry);
+			DmCacheEntry_free(entry);
+		}
+	}
 
 	(void) mtx_unlock(&slf->lock);
-	return rv;
+	return DmResult_SUCCESS;
 }
 
-DmResult DmLoader_getStyle(DmLoader* slf, DmReference const* ref, DmStyle** sty) {
-	if (slf == NULL || ref == NULL || sty == NULL) {
+DmResult DmLoader_getResolverStats(DmLoader* slf, DmLoaderResolverStats* stats, size_t* count) {
+	if (slf == NULL || count == NULL || (stats == NULL && *count != 0)) {
 		return DmResult_INVALID_ARGUMENT;
 	}
 
-	// If no file reference is provided, we're unable to load this.
-	if (ref->file == NULL) {
-		return DmResult_NOT_FOUND;
+	if (mtx_lock(&slf->lock) != thrd_success) {
+		return DmResult_MUTEX_ERROR;
+	}
+
+	DmResolverList* resolvers = slf->resolvers;
+	size_t length = resolvers != NULL ? resolvers->length : 0;
+
+	for (size_t i = 0; i < length && i < *count; ++i) {
+		stats[i].hits = atomic_load(&resolvers->data[i].counters->hits);
+		stats[i].misses = atomic_load(&resolvers->data[i].counters->misses);
+	}
+
+	*count = length;
+
+	(void) mtx_unlock(&slf->lock);
+	return DmResult_SUCCESS;
+}
+
+static void DmLoader_getBandKey(DmBand const* band, char* key) {
+	for (size_t i = 0; i < sizeof band->guid.data; ++i) {
+		(void) snprintf(key + i * 2, 3, "%02x", band->guid.data[i]);
 	}
 
-	// See if we have the requested item in the cache.
+	(void) snprintf(key + 32, 17, "%016llx", (unsigned long long) band->hash);
+}
+
+// Replace the bands of a newly parsed segment with identical bands of segments loaded before. This way, every band
+// is only downloaded once and the synthesizer can tell that a band sent again has not changed.
+static DmResult DmLoader_internBands(DmLoader* slf, DmSegment* sgt) {
+	static DmGuid const null = {{0}};
+
 	if (mtx_lock(&slf->lock) != thrd_success) {
 		return DmResult_MUTEX_ERROR;
 	}
 
-	for (size_t i = 0; i < slf->style_cache.length; ++i) {
-		if (!DmGuid_equals(&ref->guid, &slf->style_cache.data[i]->guid)) {
+	DmResult rv = DmResult_SUCCESS;
+	for (size_t i = 0; i < sgt->messages.length; ++i) {
+		DmMessage_Band* msg = &sgt->messages.data[i].band;
+		if (msg->type != DmMessage_BAND || msg->band == NULL) {
 			continue;
 		}
 
-		*sty = DmStyle_retain(slf->style_cache.data[i]);
+		// Bands are looked up by their key alone, since bands sharing a GUID might still differ.
+		char key[DmInt_LOADER_BAND_KEY_LENGTH];
+		DmLoader_getBandKey(msg->band, key);
 
-		(void) mtx_unlock(&slf->lock);
-		return DmResult_SUCCESS;
+		DmCacheEntry* entry = DmCache_find(&slf->band_cache, NULL, key);
+		if (entry != NULL) {
+			entry->last_used = ++slf->cache_clock;
+			DmCache_touch(&slf->band_cache, entry);
+			DmBand_release(msg->band);
+			msg->band = DmBand_retain(entry->object);
+			continue;
+		}
+
+		rv = DmCache_insert(&slf->band_cache, &null, key, &entry);
+		if (rv != DmResult_SUCCESS) {
+			break;
+		}
+
+		entry->state = DmCacheState_READY;
+		entry->object = DmBand_retain(msg->band);
+		entry->size = sizeof *msg->band + msg->band->instruments_len * sizeof *msg->band->instruments +
+		    DmArena_getSize(&msg->band->arena);
+		entry->last_used = ++slf->cache_clock;
+		DmCache_touch(&slf->band_cache, entry);
+		slf->band_cache.size += entry->size;
 	}
 
 	(void) mtx_unlock(&slf->lock);
+	return rv;
+}
+
+static DmResult DmLoader_parseSegment(DmLoader* slf, DmLoaderBuffer* buf, void** out) {
+	DmSegment* sgt = NULL;
+	DmResult rv = DmSegment_create(&sgt);
+	if (rv != DmResult_SUCCESS) {
+		Dm_releaseBuffer(buf->data, buf->length, buf->release, buf->context);
+		return rv;
+	}
+
+	sgt->backing_release = buf->release;
+	sgt->backing_context = buf->context;
+
+	rv = DmSegment_parse(sgt, buf->data, buf->length);
+	if (rv == DmResult_SUCCESS) {
+		rv = DmLoader_internBands(slf, sgt);
+	}
+
+	if (rv != DmResult_SUCCESS) {
+		DmSegment_release(sgt);
+		return rv;
+	}
+
+	*out = sgt;
+	return DmResult_SUCCESS;
+}
+
+// Resolve and parse a segment without downloading it.
+static DmResult DmLoader_loadSegment(DmLoader* slf, char const* name, DmSegment** segment) {
+	uint64_t start = Dm_getMonotonicTime();
+
+	DmLoaderBuffer buf;
+	if (!DmLoader_resolveName(slf, name, &buf)) {
+		Dm_report(DmLogLevel_DEBUG, "DmLoader: Segment '%s' not found", name);
+		return DmResult_NOT_FOUND;
+	}
+
+	Dm_report(DmLogLevel_DEBUG, "DmLoader: Loading segment '%s'", name);
+	return DmLoader_parseMeasured(slf,
+	                              DmLoaderAsset_SEGMENT,
+	                              name,
+	                              DmLoader_parseSegment,
+	                              &buf,
+	                              start,
+	                              (void**) segment);
+}
+
+DmResult DmLoader_probeSegment(DmLoader* slf, char const* name, DmSegmentInfo* info) {
+	if (slf == NULL || name == NULL || info == NULL) {
+		return DmResult_INVALID_ARGUMENT;
+	}
 
-	// Resolve and parse the DLS
-	size_t length = 0;
-	void* bytes = DmLoader_resolveName(slf, ref->file, &length);
-	if (bytes == NULL) {
-		Dm_report(DmLogLevel_DEBUG, "DmLoader: Style '%s' not found", ref->name);
+	DmLoaderBuffer buf;
+	if (!DmLoader_resolveName(slf, name, &buf)) {
+		Dm_report(DmLogLevel_DEBUG, "DmLoader: Segment '%s' not found", name);
 		return DmResult_NOT_FOUND;
 	}
 
-	DmResult rv = DmStyle_create(sty);
+	DmResult rv = DmSegment_probe(info, buf.data, buf.length);
+	Dm_releaseBuffer(buf.data, buf.length, buf.release, buf.context);
+	return rv;
+}
+
+DmResult DmLoader_getSegment(DmLoader* slf, char const* name, DmSegment** segment) {
+	if (slf == NULL || name == NULL || segment == NULL) {
+		return DmResult_INVALID_ARGUMENT;
+	}
+
+	DmResult rv = DmLoader_loadSegment(slf, name, segment);
 	if (rv != DmResult_SUCCESS) {
-		Dm_free(bytes);
 		return rv;
 	}
 
-	Dm_report(DmLogLevel_DEBUG, "DmLoader: Loading style '%s'", ref->file);
+	if (!slf->autodownload) {
+		return DmResult_SUCCESS;
+	}
 
-	rv = DmStyle_parse(*sty, bytes, length);
+	rv = DmSegment_download(*segment, slf);
 	if (rv != DmResult_SUCCESS) {
-		DmStyle_release(*sty);
+		Dm_report(DmLogLevel_ERROR, "DmLoader: Automatic download of segment '%s' failed", name);
+		DmSegment_release(*segment);
 		return rv;
 	}
 
-	// Add the new item to the cache
-	if (mtx_lock(&slf->lock) != thrd_success) {
-		return DmResult_MUTEX_ERROR;
+	Dm_report(DmLogLevel_INFO, "DmLoader: Automatic download of segment '%s' succeeded", name);
+	return DmResult_SUCCESS;
+}
+
+// The state of one call to DmLoader_getSegmentAsync. The segment is parsed by one task, after which every band
+// and style it references is downloaded by a separate task. The last task to finish invokes the callback.
+typedef struct DmSegmentLoad {
+	DmLoader* loader;
+	DmLoaderSegmentCallback* callback;
+	void* context;
+
+	DmSegment* segment;
+	_Atomic size_t pending;
+	_Atomic int result;
+
+	char name[];
+} DmSegmentLoad;
+
+typedef struct DmSegmentLoadTask {
+	DmSegmentLoad* load;
+	DmMessage* message;
+} DmSegmentLoadTask;
+
+// The load holds a reference to the loader, which is released last since the callback may have released all other
+// references to it.
+static void DmSegmentLoad_free(DmSegmentLoad* slf) {
+	DmLoader* loader = slf->loader;
+	Dm_free(slf);
+	DmLoader_release(loader);
+}
+
+static void DmSegmentLoad_finish(DmSegmentLoad* slf) {
+	DmResult rv = (DmResult) atomic_load(&slf->result);
+
+	// Styles referenced more than once are only downloaded by one task. Fill in the remaining references from the
+	// cache now that all tasks are done.
+	for (size_t i = 0; i < slf->segment->messages.length && rv == DmResult_SUCCESS; ++i) {
+		DmMessage* msg = &slf->segment->messages.data[i];
+		if (msg->type == DmMessage_STYLE && msg->style.style == NULL) {
+			rv = DmLoader_getStyle(slf->loader, &msg->style.reference, &msg->style.style);
+		}
 	}
 
-	rv = DmStyleCache_add(&slf->style_cache, DmStyle_retain(*sty));
+	slf->segment->downloaded = true;
 
+	if (rv != DmResult_SUCCESS) {
+		Dm_report(DmLogLevel_ERROR, "DmLoader: Automatic download of segment '%s' failed", slf->name);
+		DmSegment_release(slf->segment);
+		slf->segment = NULL;
+	} else {
+		Dm_report(DmLogLevel_INFO, "DmLoader: Automatic download of segment '%s' succeeded", slf->name);
+	}
+
+	slf->callback(slf->context, rv, slf->segment);
+	DmSegmentLoad_free(slf);
+}
+
+static void DmSegmentLoad_complete(DmSegmentLoad* slf, DmResult rv) {
+	if (rv != DmResult_SUCCESS) {
+		int expected = DmResult_SUCCESS;
+		(void) atomic_compare_exchange_strong(&slf->result, &expected, (int) rv);
+	}
+
+	if (atomic_fetch_sub(&slf->pending, 1) == 1) {
+		DmSegmentLoad_finish(slf);
+	}
+}
+
+static void DmSegmentLoad_runMessage(void* ctx) {
+	DmSegmentLoadTask* task = ctx;
+	DmSegmentLoad* load = task->load;
+	DmMessage* msg = task->message;
+	Dm_free(task);
+
+	DmResult rv = DmResult_SUCCESS;
+	if (msg->type == DmMessage_BAND) {
+		rv = DmBand_download(msg->band.band, load->loader);
+	} else {
+		rv = DmLoader_getStyle(load->loader, &msg->style.reference, &msg->style.style);
+		if (rv == DmResult_SUCCESS) {
+			rv = DmStyle_download(msg->style.style, load->loader);
+		}
+	}
+
+	DmSegmentLoad_complete(load, rv);
+}
+
+static bool DmSegment_isDuplicateStyle(DmSegment* slf, size_t index) {
+	DmMessage* msg = &slf->messages.data[index];
+	for (size_t i = 0; i < index; ++i) {
+		DmMessage* other = &slf->messages.data[i];
+		if (other->type == DmMessage_STYLE && DmGuid_equals(&other->style.reference.guid, &msg->style.reference.guid)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void DmSegmentLoad_run(void* ctx) {
+	DmSegmentLoad* slf = ctx;
+
+	DmResult rv = DmLoader_loadSegment(slf->loader, slf->name, &slf->segment);
+	if (rv != DmResult_SUCCESS) {
+		slf->callback(slf->context, rv, NULL);
+		DmSegmentLoad_free(slf);
+		return;
+	}
+
+	if (!slf->loader->autodownload || slf->segment->downloaded) {
+		slf->callback(slf->context, DmResult_SUCCESS, slf->segment);
+		DmSegmentLoad_free(slf);
+		return;
+	}
+
+	// Hold on to one pending count while submitting tasks, so that the load is not finished early.
+	slf->pending = 1;
+	slf->result = DmResult_SUCCESS;
+
+	for (size_t i = 0; i < slf->segment->messages.length; ++i) {
+		DmMessage* msg = &slf->segment->messages.data[i];
+
+		if (msg->type != DmMessage_BAND && msg->type != DmMessage_STYLE) {
+			continue;
+		}
+
+		if (msg->type == DmMessage_STYLE && DmSegment_isDuplicateStyle(slf->segment, i)) {
+			continue;
+		}
+
+		DmSegmentLoadTask* task = Dm_alloc(sizeof *task);
+		if (task == NULL) {
+			DmSegmentLoad_complete(slf, DmResult_MEMORY_EXHAUSTED);
+			return;
+		}
+
+		task->load = slf;
+		task->message = msg;
+
+		(void) atomic_fetch_add(&slf->pending, 1);
+		if (DmWorkerPool_submit(slf->loader->workers, DmSegmentLoad_runMessage, task) != DmResult_SUCCESS) {
+			// We can't run the task in parallel, so we just run it right here.
+			DmSegmentLoad_runMessage(task);
+		}
+	}
+
+	DmSegmentLoad_complete(slf, DmResult_SUCCESS);
+}
+
+// Create the worker pool if it does not exist yet.
+static DmResult DmLoader_startWorkers(DmLoader* slf) {
+	if (mtx_lock(&slf->lock) != thrd_success) {
+		return DmResult_MUTEX_ERROR;
+	}
+
+	DmResult rv = DmResult_SUCCESS;
+	if (slf->workers == NULL) {
+		rv = DmWorkerPool_create(&slf->workers, DmInt_LOADER_WORKER_COUNT);
+	}
+
+	(void) mtx_unlock(&slf->lock);
+	return rv;
+}
+
+DmResult DmLoader_getSegmentAsync(DmLoader* slf, char const* name, DmLoaderSegmentCallback* cb, void* ctx) {
+	if (slf == NULL || name == NULL || cb == NULL) {
+		return DmResult_INVALID_ARGUMENT;
+	}
+
+	DmResult rv = DmLoader_startWorkers(slf);
+	if (rv != DmResult_SUCCESS) {
+		return rv;
+	}
+
+	size_t name_length = strlen(name);
+	DmSegmentLoad* load = Dm_alloc(sizeof *load + name_length + 1);
+	if (load == NULL) {
+		return DmResult_MEMORY_EXHAUSTED;
+	}
+
+	load->loader = DmLoader_retain(slf);
+	load->callback = cb;
+	load->context = ctx;
+	memcpy(load->name, name, name_length + 1);
+
+	rv = DmWorkerPool_submit(slf->workers, DmSegmentLoad_run, load);
+	if (rv != DmResult_SUCCESS) {
+		DmSegmentLoad_free(load);
+		return rv;
+	}
+
+	return DmResult_SUCCESS;
+}
+
+// The shared state of one call to DmLoader_preload.
+typedef struct DmPreload {
+	DmLoader* loader;
+	DmPreloadOptions options;
+	bool keep_segments;
+
+	mtx_t lock;
+	cnd_t done;
+	size_t pending;
+} DmPreload;
+
+typedef struct DmPreloadTask {
+	DmPreload* preload;
+	char const* name;
+	DmSegment* segment;
+	DmPreloadResult result;
+} DmPreloadTask;
+
+static void DmPreload_visitBand(DmBand* band, DmPreloadOptions opt, DmResult* rv) {
+	for (size_t i = 0; i < band->instruments_len && *rv == DmResult_SUCCESS; ++i) {
+		DmDls* dls = band->instruments[i].dls;
+		if (dls == NULL) {
+			continue;
+		}
+
+		if (opt & DmPreload_TOUCH) {
+			Dm_touchMemory(dls->backing_memory, dls->backing_length);
+		}
+
+		if (opt & DmPreload_FONTS) {
+			*rv = DmDls_getFont(dls, NULL);
+		}
+	}
+}
+
+// Build fonts for and touch all objects referenced by a downloaded segment. The segment itself is touched by the
+// caller, since it is only worth paging in if it is kept.
+static DmResult DmPreload_visitSegment(DmSegment* sgt, DmPreloadOptions opt) {
+	DmResult rv = DmResult_SUCCESS;
+	for (size_t i = 0; i < sgt->messages.length && rv == DmResult_SUCCESS; ++i) {
+		DmMessage* msg = &sgt->messages.data[i];
+
+		if (msg->type == DmMessage_BAND && msg->band.band != NULL) {
+			DmPreload_visitBand(msg->band.band, opt, &rv);
+		} else if (msg->type == DmMessage_STYLE && msg->style.style != NULL) {
+			DmStyle* sty = msg->style.style;
+			if (opt & DmPreload_TOUCH) {
+				Dm_touchMemory(sty->backing_memory, sty->backing_length);
+			}
+
+			for (size_t k = 0; k < sty->bands.length && rv == DmResult_SUCCESS; ++k) {
+				DmPreload_visitBand(sty->bands.data[k], opt, &rv);
+			}
+		}
+	}
+
+	return rv;
+}
+
+static void DmPreloadTask_run(void* ctx) {
+	DmPreloadTask* slf = ctx;
+	DmPreload* preload = slf->preload;
+	DmPreloadResult* res = &slf->result;
+
+	DmSegment* sgt = NULL;
+	uint64_t start = Dm_getMonotonicTime();
+
+	res->result = DmLoader_loadSegment(preload->loader, slf->name, &sgt);
+	uint64_t loaded = Dm_getMonotonicTime();
+
+	if (res->result == DmResult_SUCCESS) {
+		res->result = DmSegment_download(sgt, preload->loader);
+	}
+	uint64_t downloaded = Dm_getMonotonicTime();
+
+	if (res->result == DmResult_SUCCESS && (preload->options & (DmPreload_FONTS | DmPreload_TOUCH))) {
+		res->result = DmPreload_visitSegment(sgt, preload->options);
+
+		if (preload->keep_segments && (preload->options & DmPreload_TOUCH)) {
+			Dm_touchMemory(sgt->backing_memory, sgt->backing_length);
+		}
+	}
+	uint64_t warmed = Dm_getMonotonicTime();
+
+	res->load_time = Dm_getElapsedSeconds(start, loaded);
+	res->download_time = Dm_getElapsedSeconds(loaded, downloaded);
+	res->warm_up_time = Dm_getElapsedSeconds(downloaded, warmed);
+
+	if (res->result != DmResult_SUCCESS) {
+		Dm_report(DmLogLevel_ERROR, "DmLoader: Preloading segment '%s' failed", slf->name);
+	} else {
+		Dm_report(DmLogLevel_DEBUG,
+		          "DmLoader: Preloaded segment '%s' (load: %.3fs, download: %.3fs, warm-up: %.3fs)",
+		          slf->name,
+		          res->load_time,
+		          res->download_time,
+		          res->warm_up_time);
+	}
+
+	// The objects referenced by the segment stay in the loader's caches, even if the segment itself is released.
+	if (preload->keep_segments && res->result == DmResult_SUCCESS) {
+		slf->segment = sgt;
+	} else {
+		DmSegment_release(sgt);
+	}
+
+	if (mtx_lock(&preload->lock) == thrd_success) {
+		preload->pending -= 1;
+		(void) cnd_signal(&preload->done);
+		(void) mtx_unlock(&preload->lock);
+	}
+}
+
+DmResult DmLoader_preload(DmLoader* slf,
+                          char const* const* names,
+                          size_t count,
+                          DmPreloadOptions opt,
+                          DmSegment** segments,
+                          DmPreloadResult* results) {
+	if (slf == NULL || (names == NULL && count != 0)) {
+		return DmResult_INVALID_ARGUMENT;
+	}
+
+	if (count == 0) {
+		return DmResult_SUCCESS;
+	}
+
+	DmResult rv = DmLoader_startWorkers(slf);
+	if (rv != DmResult_SUCCESS) {
+		return rv;
+	}
+
+	DmPreloadTask* tasks = Dm_alloc(count * sizeof *tasks);
+	if (tasks == NULL) {
+		return DmResult_MEMORY_EXHAUSTED;
+	}
+
+	DmPreload preload;
+	preload.loader = slf;
+	preload.options = opt;
+	preload.keep_segments = segments != NULL;
+	preload.pending = 0;
+
+	if (mtx_init(&preload.lock, mtx_plain) != thrd_success) {
+		Dm_free(tasks);
+		return DmResult_MUTEX_ERROR;
+	}
+
+	if (cnd_init(&preload.done) != thrd_success) {
+		mtx_destroy(&preload.lock);
+		Dm_free(tasks);
+		return DmResult_MUTEX_ERROR;
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		tasks[i].preload = &preload;
+		tasks[i].name = names[i];
+		tasks[i].segment = NULL;
+
+		if (names[i] == NULL) {
+			tasks[i].result.result = DmResult_INVALID_ARGUMENT;
+			continue;
+		}
+
+		(void) mtx_lock(&preload.lock);
+		preload.pending += 1;
+		(void) mtx_unlock(&preload.lock);
+
+		if (DmWorkerPool_submit(slf->workers, DmPreloadTask_run, &tasks[i]) != DmResult_SUCCESS) {
+			// We can't run the task in parallel, so we just run it right here.
+			DmPreloadTask_run(&tasks[i]);
+		}
+	}
+
+	(void) mtx_lock(&preload.lock);
+	while (preload.pending > 0) {
+		(void) cnd_wait(&preload.done, &preload.lock);
+	}
+	(void) mtx_unlock(&preload.lock);
+
+	for (size_t i = 0; i < count; ++i) {
+		if (segments != NULL) {
+			segments[i] = tasks[i].segment;
+		}
+
+		if (results != NULL) {
+			results[i] = tasks[i].result;
+		}
+
+		if (rv == DmResult_SUCCESS) {
+			rv = tasks[i].result.result;
+		}
+	}
+
+	cnd_destroy(&preload.done);
+	mtx_destroy(&preload.lock);
+	Dm_free(tasks);
+	return rv;
+}
+
+// Build the path of the font cache file for the given collection. Collections without a GUID can't be told apart
+// reliably, so they are never cached.
+static DmResult DmLoader_getFontCachePath(DmLoader* slf, DmDls* dls, char** out) {
+	static DmGuid const null = {{0}};
+	*out = NULL;
+
+	if (DmGuid_equals(&dls->guid, &null)) {
+		return DmResult_SUCCESS;
+	}
+
+	if (mtx_lock(&slf->lock) != thrd_success) {
+		return DmResult_MUTEX_ERROR;
+	}
+
+	DmResult rv = DmResult_SUCCESS;
+	if (slf->font_cache_directory != NULL) {
+		size_t dir_len = strlen(slf->font_cache_directory);
+		char* path = *out = Dm_alloc(dir_len + 1 + 32 + sizeof ".dmfont");
+
+		if (path == NULL) {
+			rv = DmResult_MEMORY_EXHAUSTED;
+		} else {
+			memcpy(path, slf->font_cache_directory, dir_len);
+			path[dir_len] = '/';
+
+			for (size_t i = 0; i < sizeof dls->guid.data; ++i) {
+				(void) snprintf(path + dir_len + 1 + i * 2, 3, "%02x", dls->guid.data[i]);
+			}
+
+			memcpy(path + dir_len + 1 + 32, ".dmfont", sizeof ".dmfont");
+		}
+	}
+
+	(void) mtx_unlock(&slf->lock);
+	return rv;
+}
+
+static DmResult DmLoader_parseDls(DmLoader* slf, DmLoaderBuffer* buf, void** out) {
+	DmDls* dls = NULL;
+	DmResult rv = DmDls_create(&dls);
+	if (rv != DmResult_SUCCESS) {
+		Dm_releaseBuffer(buf->data, buf->length, buf->release, buf->context);
+		return rv;
+	}
+
+	dls->backing_release = buf->release;
+	dls->backing_context = buf->context;
+	dls->stream = slf->stream;
+	dls->font_memory = &slf->font_memory;
+
+	rv = DmDls_parse(dls, buf->data, buf->length);
+	if (rv == DmResult_SUCCESS) {
+		rv = DmLoader_getFontCachePath(slf, dls, &dls->font_cache_path);
+	}
+
+	if (rv != DmResult_SUCCESS) {
+		DmDls_release(dls);
+		return rv;
+	}
+
+	*out = dls;
+	return DmResult_SUCCESS;
+}
+
+static DmResult DmLoader_parseStyle(DmLoader* slf, DmLoaderBuffer* buf, void** out) {
+	(void) slf;
+
+	DmStyle* sty = NULL;
+	DmResult rv = DmStyle_create(&sty);
+	if (rv != DmResult_SUCCESS) {
+		Dm_releaseBuffer(buf->data, buf->length, buf->release, buf->context);
+		return rv;
+	}
+
+	sty->backing_release = buf->release;
+	sty->backing_context = buf->context;
+
+	rv = DmStyle_parse(sty, buf->data, buf->length);
+	if (rv != DmResult_SUCCESS) {
+		DmStyle_release(sty);
+		return rv;
+	}
+
+	*out = sty;
+	return DmResult_SUCCESS;
+}
+
+// Find the statistics of the given file. Must be called with the loader's lock held.
+static DmLoaderAssetStats* DmLoader_findStats(DmLoader* slf, DmLoaderAssetType type, char const* name) {
+	if (slf->stats_bucket_count == 0) {
+		return NULL;
+	}
+
+	// Names are truncated when they are recorded, so they need to be truncated for lookups as well.
+	char key[sizeof slf->stats.data->stats.name] = {0};
+	strncpy(key, name, sizeof key - 1);
+
+	size_t index = slf->stats_buckets[DmCache_hashFile(key) % slf->stats_bucket_count];
+	while (index != 0) {
+		DmLoaderStatsRecord* record = &slf->stats.data[index - 1];
+		if (record->stats.type == type && DmCache_fileEquals(record->stats.name, key)) {
+			return &record->stats;
+		}
+
+		index = record->next;
+	}
+
+	return NULL;
+}
+
+static void DmLoader_linkStats(DmLoader* slf, size_t index) {
+	DmLoaderStatsRecord* record = &slf->stats.data[index];
+	size_t bucket = DmCache_hashFile(record->stats.name) % slf->stats_bucket_count;
+
+	record->next = slf->stats_buckets[bucket];
+	slf->stats_buckets[bucket] = index + 1;
+}
+
+// Add the last record of the loader's statistics to the index. If the index can't grow, its chains get longer
+// instead. Must be called with the loader's lock held.
+static DmResult DmLoader_indexStats(DmLoader* slf) {
+	size_t index = slf->stats.length - 1;
+
+	if (slf->stats.length > slf->stats_bucket_count) {
+		size_t count =
+		    slf->stats_bucket_count == 0 ? DmInt_LOADER_STATS_INITIAL_BUCKETS : slf->stats_bucket_count * 2;
+		size_t* buckets = Dm_alloc(count * sizeof *buckets);
+
+		if (buckets != NULL) {
+			Dm_free(slf->stats_buckets);
+			slf->stats_buckets = buckets;
+			slf->stats_bucket_count = count;
+
+			for (size_t i = 0; i < index; ++i) {
+				DmLoader_linkStats(slf, i);
+			}
+		} else if (slf->stats_buckets == NULL) {
+			return DmResult_MEMORY_EXHAUSTED;
+		}
+	}
+
+	DmLoader_linkStats(slf, index);
+	return DmResult_SUCCESS;
+}
+
+// Get the time spent building the font of a cached DLS collection. Fonts are built outside the loader, so the time
+// is only read from the collection when it is needed. Must be called with the loader's lock held.
+static double DmLoader_getFontTime(DmLoader* slf, char const* name) {
+	DmCacheEntry* entry = DmCache_find(&slf->dls_cache, NULL, name);
+	if (entry == NULL || entry->state != DmCacheState_READY) {
+		return 0;
+	}
+
+	DmDls* dls = entry->object;
+	return Dm_getElapsedSeconds(0, atomic_load(&dls->font_time));
+}
+
+static void DmLoader_recordStats(DmLoader* slf,
+                                 DmLoaderAssetType type,
+                                 char const* name,
+                                 DmResult result,
+                                 DmLoaderStats const* stats) {
+	if (mtx_lock(&slf->lock) != thrd_success) {
+		return;
+	}
+
+	DmLoaderAssetStats* it = DmLoader_findStats(slf, type, name);
+	if (it == NULL) {
+		DmLoaderStatsRecord new;
+		memset(&new, 0, sizeof new);
+		new.stats.type = type;
+		strncpy(new.stats.name, name, sizeof new.stats.name - 1);
+
+		// Statistics are best-effort, so they are dropped if they can't be stored.
+		if (DmLoaderStatsRecordList_add(&slf->stats, new) == DmResult_SUCCESS) {
+			if (DmLoader_indexStats(slf) == DmResult_SUCCESS) {
+				it = &slf->stats.data[slf->stats.length - 1].stats;
+			} else {
+				slf->stats.length -= 1;
+			}
+		}
+	}
+
+	if (it != NULL) {
+		it->result = result;
+		it->stats.count += stats->count;
+		it->stats.resolve_time += stats->resolve_time;
+		it->stats.bytes_read += stats->bytes_read;
+		it->stats.parse_time += stats->parse_time;
+		it->stats.allocations += stats->allocations;
+		it->stats.allocated_bytes += stats->allocated_bytes;
+	}
+
+	(void) mtx_unlock(&slf->lock);
+}
+
+// Parse a buffer returned by a resolver and record statistics about the load. Allocation counters are kept per
+// thread, so only allocations made on the calling thread are counted.
+static DmResult DmLoader_parseMeasured(DmLoader* slf,
+                                       DmLoaderAssetType type,
+                                       char const* name,
+                                       DmLoaderParse* parse,
+                                       DmLoaderBuffer* buf,
+                                       uint64_t resolve_start,
+                                       void** out) {
+	DmLoaderStats stats;
+	memset(&stats, 0, sizeof stats);
+	stats.count = 1;
+	stats.bytes_read = buf->length;
+
+	size_t allocations = 0;
+	size_t allocated_bytes = 0;
+	Dm_getAllocationCounters(&allocations, &allocated_bytes);
+
+	uint64_t start = Dm_getMonotonicTime();
+	stats.resolve_time = Dm_getElapsedSeconds(resolve_start, start);
+
+	DmResult rv = parse(slf, buf, out);
+
+	stats.parse_time = Dm_getElapsedSeconds(start, Dm_getMonotonicTime());
+	Dm_getAllocationCounters(&stats.allocations, &stats.allocated_bytes);
+	stats.allocations -= allocations;
+	stats.allocated_bytes -= allocated_bytes;
+
+	DmLoader_recordStats(slf, type, name, rv, &stats);
+	return rv;
+}
+
+// Fonts are built outside the loader, so their memory is counted separately. See DmDls::font_memory.
+static size_t DmLoader_getMemoryUsed(DmLoader* slf) {
+	return slf->dls_cache.size + slf->style_cache.size + slf->band_cache.size + atomic_load(&slf->font_memory);
+}
+
+// Evict the least recently used objects, which are not referenced outside the loader, until the total size of all
+// cached objects fits the memory budget. Must be called with the loader's lock held.
+static void DmLoader_evict(DmLoader* slf) {
+	if (slf->memory_budget == 0) {
+		return;
+	}
+
+	// Bands keep their DLS collections alive, so evicting a band can make a collection evictable.
+	DmCache* caches[] = {&slf->dls_cache, &slf->style_cache, &slf->band_cache};
+
+	while (DmLoader_getMemoryUsed(slf) > slf->memory_budget) {
+		DmCache* cache = NULL;
+		DmCacheEntry* entry = NULL;
+
+		for (size_t i = 0; i < sizeof caches / sizeof *caches; ++i) {
+			DmCacheEntry* candidate = DmCache_findEvictable(caches[i]);
+			if (candidate != NULL && (entry == NULL || candidate->last_used < entry->last_used)) {
+				cache = caches[i];
+				entry = candidate;
+			}
+		}
+
+		if (entry == NULL) {
+			break;
+		}
+
+		Dm_report(DmLogLevel_DEBUG, "DmLoader: Evicting '%s' (%zu bytes)", entry->file, entry->size);
+
+		if (cache == &slf->dls_cache) {
+			DmLoaderAssetStats* stats = DmLoader_findStats(slf, DmLoaderAsset_DLS, entry->file);
+			if (stats != NULL) {
+				stats->stats.font_time += DmLoader_getFontTime(slf, entry->file);
+			}
+		}
+
+		DmCache_remove(cache, entry);
+		cache->release(entry->object);
+		DmCacheEntry_free(entry);
+		slf->cache_evictions += 1;
+	}
+}
+
+// Get the object referenced by `ref` from the given cache or load it if it is not cached yet. Only one thread
+// loads any given object. Other threads requesting the same object at the same time wait for it to finish and
+// share its result.
+static DmResult DmLoader_getCached(DmLoader* slf,
+                                   DmCache* cache,
+                                   DmReference const* ref,
+                                   DmLoaderAssetType type,
+                                   char const* kind,
+                                   DmLoaderParse* parse,
+                                   void** out) {
+	if (mtx_lock(&slf->lock) != thrd_success) {
+		return DmResult_MUTEX_ERROR;
+	}
+
+	// See if we have the requested item in the cache or if it is currently being loaded.
+	DmCacheEntry* entry = DmCache_find(cache, &ref->guid, ref->file);
+	if (entry != NULL) {
+		slf->cache_hits += 1;
+		entry->waiters += 1;
+		while (entry->state == DmCacheState_LOADING) {
+			(void) cnd_wait(&slf->loaded, &slf->lock);
+		}
+		entry->waiters -= 1;
+
+		DmResult rv = entry->result;
+		if (entry->state == DmCacheState_READY) {
+			entry->last_used = ++slf->cache_clock;
+			DmCache_touch(cache, entry);
+			*out = cache->retain(entry->object);
+		} else if (entry->waiters == 0) {
+			// Failed entries are already removed from the cache. The last waiter cleans them up.
+			DmCacheEntry_free(entry);
+		}
+
+		(void) mtx_unlock(&slf->lock);
+		return rv;
+	}
+
+	slf->cache_misses += 1;
+	DmResult rv = DmCache_insert(cache, &ref->guid, ref->file, &entry);
+	(void) mtx_unlock(&slf->lock);
+
+	if (rv != DmResult_SUCCESS) {
+		return rv;
+	}
+
+	// Resolve and parse the object
+	DmLoaderBuffer buf;
+	void* obj = NULL;
+
+	uint64_t start = Dm_getMonotonicTime();
+	if (!DmLoader_resolveName(slf, ref->file, &buf)) {
+		Dm_report(DmLogLevel_DEBUG, "DmLoader: %s '%s' not found", kind, ref->name);
+		rv = DmResult_NOT_FOUND;
+	} else {
+		Dm_report(DmLogLevel_DEBUG, "DmLoader: Loading %s '%s'", kind, ref->file);
+		rv = DmLoader_parseMeasured(slf, type, ref->file, parse, &buf, start, &obj);
+	}
+
+	// Publish the result to all waiting threads.
+	if (mtx_lock(&slf->lock) != thrd_success) {
+		// This should never happen but if it does, we leak the entry instead of crashing.
+		return DmResult_MUTEX_ERROR;
+	}
+
+	entry->result = rv;
+	if (rv == DmResult_SUCCESS) {
+		entry->state = DmCacheState_READY;
+		entry->object = obj;
+		entry->size = buf.length;
+		entry->last_used = ++slf->cache_clock;
+		DmCache_touch(cache, entry);
+		cache->size += entry->size;
+		*out = cache->retain(obj);
+
+		// The new object is referenced by the caller, so it won't be evicted right away.
+		DmLoader_evict(slf);
+	} else {
+		entry->state = DmCacheState_FAILED;
+		DmCache_remove(cache, entry);
+
+		if (entry->waiters == 0) {
+			DmCacheEntry_free(entry);
+		}
+	}
+
+	(void) cnd_broadcast(&slf->loaded);
 	(void) mtx_unlock(&slf->lock);
 	return rv;
 }
+
+DmResult DmLoader_getDownloadableSound(DmLoader* slf, DmReference const* ref, DmDls** snd) {
+	if (slf == NULL || ref == NULL || snd == NULL) {
+		return DmResult_INVALID_ARGUMENT;
+	}
+
+	// If no file reference is provided, we're unable to load this.
+	if (ref->file == NULL) {
+		return DmResult_NOT_FOUND;
+	}
+
+	return DmLoader_getCached(slf,
+	                          &slf->dls_cache,
+	                          ref,
+	                          DmLoaderAsset_DLS,
+	                          "DLS collection",
+	                          DmLoader_parseDls,
+	                          (void**) snd);
+}
+
+DmResult DmLoader_getStyle(DmLoader* slf, DmReference const* ref, DmStyle** sty) {
+	if (slf == NULL || ref == NULL || sty == NULL) {
+		return DmResult_INVALID_ARGUMENT;
+	}
+
+	// If no file reference is provided, we're unable to load this.
+	if (ref->file == NULL) {
+		return DmResult_NOT_FOUND;
+	}
+
+	return DmLoader_getCached(slf,
+	                          &slf->style_cache,
+	                          ref,
+	                          DmLoaderAsset_STYLE,
+	                          "style",
+	                          DmLoader_parseStyle,
+	                          (void**) sty);
+}
+
+DmResult DmLoader_setMemoryBudget(DmLoader* slf, size_t budget) {
+	if (slf == NULL) {
+		return DmResult_INVALID_ARGUMENT;
+	}
+
+	if (mtx_lock(&slf->lock) != thrd_success) {
+		return DmResult_MUTEX_ERROR;
+	}
+
+	slf->memory_budget = budget;
+	DmLoader_evict(slf);
+
+	(void) mtx_unlock(&slf->lock);
+	return DmResult_SUCCESS;
+}
+
+DmResult DmLoader_getCacheStats(DmLoader* slf, DmLoaderCacheStats* stats) {
+	if (slf == NULL || stats == NULL) {
+		return DmResult_INVALID_ARGUMENT;
+	}
+
+	if (mtx_lock(&slf->lock) != thrd_success) {
+		return DmResult_MUTEX_ERROR;
+	}
+
+	stats->hits = slf->cache_hits;
+	stats->misses = slf->cache_misses;
+	stats->evictions = slf->cache_evictions;
+	stats->missing_hits = slf->missing_hits;
+	stats->memory_used = DmLoader_getMemoryUsed(slf);
+	stats->memory_budget = slf->memory_budget;
+
+	(void) mtx_unlock(&slf->lock);
+	return DmResult_SUCCESS;
+}
+
+DmResult DmLoader_setFontCacheDirectory(DmLoader* slf, char const* path) {
+	if (slf == NULL) {
+		return DmResult_INVALID_ARGUMENT;
+	}
+
+	char* copy = NULL;
+	if (path != NULL) {
+		size_t path_len = strlen(path);
+		copy = Dm_alloc(path_len + 1);
+		if (copy == NULL) {
+			return DmResult_MEMORY_EXHAUSTED;
+		}
+
+		memcpy(copy, path, path_len + 1);
+	}
+
+	if (mtx_lock(&slf->lock) != thrd_success) {
+		Dm_free(copy);
+		return DmResult_MUTEX_ERROR;
+	}
+
+	char* old = slf->font_cache_directory;
+	slf->font_cache_directory = copy;
+
+	(void) mtx_unlock(&slf->lock);
+
+	Dm_free(old);
+	return DmResult_SUCCESS;
+}
+
+DmResult DmLoader_getStats(DmLoader* slf, DmLoaderAssetType type, DmLoaderStats* stats) {
+	if (slf == NULL || stats == NULL) {
+		return DmResult_INVALID_ARGUMENT;
+	}
+
+	if (mtx_lock(&slf->lock) != thrd_success) {
+		return DmResult_MUTEX_ERROR;
+	}
+
+	memset(stats, 0, sizeof *stats);
+	for (size_t i = 0; i < slf->stats.length; ++i) {
+		DmLoaderAssetStats const* it = &slf->stats.data[i].stats;
+		if (it->type != type) {
+			continue;
+		}
+
+		stats->count += it->stats.count;
+		stats->resolve_time += it->stats.resolve_time;
+		stats->bytes_read += it->stats.bytes_read;
+		stats->parse_time += it->stats.parse_time;
+		stats->allocations += it->stats.allocations;
+		stats->allocated_bytes += it->stats.allocated_bytes;
+		stats->font_time += it->stats.font_time;
+
+		if (type == DmLoaderAsset_DLS) {
+			stats->font_time += DmLoader_getFontTime(slf, it->name);
+		}
+	}
+
+	(void) mtx_unlock(&slf->lock);
+	return DmResult_SUCCESS;
+}
+
+DmResult DmLoader_getAssetStats(DmLoader* slf, DmLoaderAssetStats* stats, size_t* count) {
+	if (slf == NULL || count == NULL || (stats == NULL && *count != 0)) {
+		return DmResult_INVALID_ARGUMENT;
+	}
+
+	if (mtx_lock(&slf->lock) != thrd_success) {
+		return DmResult_MUTEX_ERROR;
+	}
+
+	for (size_t i = 0; i < slf->stats.length && i < *count; ++i) {
+		stats[i] = slf->stats.data[i].stats;
+
+		if (stats[i].type == DmLoaderAsset_DLS) {
+			stats[i].stats.font_time += DmLoader_getFontTime(slf, stats[i].name);
+		}
+	}
+
+	*count = slf->stats.length;
+
+	(void) mtx_unlock(&slf->lock);
+	return DmResult_SUCCESS;
+}
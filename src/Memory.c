@@ -5,14 +5,32 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+#endif
+
 static void* DmInt_defaultAlloc(void* ctx, size_t len);
 static void DmInt_defaultFree(void* ctx, void* ptr);
+static void* DmInt_defaultRealloc(void* ctx, void* ptr, size_t len);
+
+#if defined(_MSC_VER) && !defined(__clang__)
+	#define DM_THREAD_LOCAL __declspec(thread)
+#else
+	#define DM_THREAD_LOCAL _Thread_local
+#endif
 
 static _Atomic size_t DmGlob_allocCount = 0;
+static DM_THREAD_LOCAL size_t DmGlob_threadAllocCount = 0;
+static DM_THREAD_LOCAL size_t DmGlob_threadAllocBytes = 0;
 static void* DmGlob_allocContext = NULL;
 static DmMemoryAlloc* DmGlob_alloc = DmInt_defaultAlloc;
 static DmMemoryFree* DmGlob_free = DmInt_defaultFree;
+static DmMemoryRealloc* DmGlob_realloc = DmInt_defaultRealloc;
 
+// The default re-allocator only works with the default allocator, so a custom allocator resets it.
 DmResult Dm_setHeapAllocator(DmMemoryAlloc* alloc, DmMemoryFree* free, void* ctx) {
 	if (DmGlob_allocCount != 0) {
 		return DmResult_INVALID_STATE;
@@ -25,24 +43,85 @@ DmResult Dm_setHeapAllocator(DmMemoryAlloc* alloc, DmMemoryFree* free, void* ctx
 	DmGlob_allocContext = ctx;
 	DmGlob_alloc = alloc;
 	DmGlob_free = free;
+	DmGlob_realloc = NULL;
+
+	return DmResult_SUCCESS;
+}
+
+DmResult Dm_setHeapReallocator(DmMemoryRealloc* realloc) {
+	if (DmGlob_allocCount != 0) {
+		return DmResult_INVALID_STATE;
+	}
 
+	DmGlob_realloc = realloc;
 	return DmResult_SUCCESS;
 }
 
 void* Dm_alloc(size_t len) {
+	void* mem = Dm_allocUninit(len);
+	if (mem == NULL) {
+		return NULL;
+	}
+
+	return memset(mem, 0, len);
+}
+
+void* Dm_allocUninit(size_t len) {
 	void* mem = DmGlob_alloc(DmGlob_allocContext, len);
 	if (mem == NULL) {
 		return NULL;
 	}
 
 	atomic_fetch_add(&DmGlob_allocCount, 1);
-	return memset(mem, 0, len);
+	DmGlob_threadAllocCount += 1;
+	DmGlob_threadAllocBytes += len;
+	return mem;
+}
+
+void* Dm_realloc(void* ptr, size_t old_len, size_t len) {
+	if (ptr == NULL) {
+		return Dm_allocUninit(len);
+	}
+
+	if (DmGlob_realloc != NULL) {
+		DmGlob_threadAllocCount += 1;
+		DmGlob_threadAllocBytes += len;
+		return DmGlob_realloc(DmGlob_allocContext, ptr, len);
+	}
+
+	// Without a re-allocation function, a new block has to be allocated and the old one copied over.
+	void* mem = Dm_allocUninit(len);
+	if (mem == NULL) {
+		return NULL;
+	}
+
+	memcpy(mem, ptr, min_usize(old_len, len));
+	Dm_free(ptr);
+	return mem;
+}
+
+void Dm_getAllocationCounters(size_t* count, size_t* bytes) {
+	*count = DmGlob_threadAllocCount;
+	*bytes = DmGlob_threadAllocBytes;
 }
 
 void Dm_free(void* ptr) {
 	DmGlob_free(DmGlob_allocContext, ptr);
 }
 
+void Dm_releaseBuffer(void* buf, size_t len, DmLoaderBufferRelease* release, void* ctx) {
+	if (buf == NULL) {
+		return;
+	}
+
+	if (release == NULL) {
+		Dm_free(buf);
+		return;
+	}
+
+	release(ctx, buf, len);
+}
+
 static void* DmInt_defaultAlloc(void* ctx, size_t len) {
 	(void) ctx;
 	return malloc(len);
@@ -52,3 +131,154 @@ static void DmInt_defaultFree(void* ctx, void* ptr) {
 	(void) ctx;
 	free(ptr);
 }
+
+static void* DmInt_defaultRealloc(void* ctx, void* ptr, size_t len) {
+	(void) ctx;
+	return realloc(ptr, len);
+}
+
+void Dm_touchMemory(void const* buf, size_t len) {
+	if (buf == NULL) {
+		return;
+	}
+
+	// The page size is not known portably, so the smallest common one is assumed.
+	uint8_t const volatile* bytes = buf;
+	uint8_t sink = 0;
+	for (size_t i = 0; i < len; i += 4096) {
+		sink ^= bytes[i];
+	}
+
+	(void) sink;
+}
+
+// Anonymous mappings are zero-filled and only backed by physical memory once a page is written to. Windows does not
+// overcommit, so there the address space is only reserved and pages are committed using Dm_commitMemory.
+void* Dm_reserveMemory(size_t len) {
+	if (len == 0) {
+		return NULL;
+	}
+
+#ifdef _WIN32
+	return VirtualAlloc(NULL, len, MEM_RESERVE, PAGE_READWRITE);
+#else
+	void* mem = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	return mem == MAP_FAILED ? NULL : mem;
+#endif
+}
+
+bool Dm_commitMemory(void* buf, size_t len) {
+	if (len == 0) {
+		return true;
+	}
+
+#ifdef _WIN32
+	// Committing pages which are already committed leaves their contents as-is.
+	return VirtualAlloc(buf, len, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+	(void) buf;
+	return true;
+#endif
+}
+
+void Dm_releaseMemory(void* buf, size_t len) {
+	if (buf == NULL) {
+		return;
+	}
+
+#ifdef _WIN32
+	(void) len;
+	VirtualFree(buf, 0, MEM_RELEASE);
+#else
+	(void) munmap(buf, len);
+#endif
+}
+
+enum {
+	DmInt_ARENA_ALIGNMENT = 16,
+};
+
+// Empty allocations still take up space, so that they return a valid pointer like most implementations of malloc.
+size_t DmArena_measure(size_t len) {
+	if (len == 0) {
+		len = 1;
+	}
+
+	return (len + DmInt_ARENA_ALIGNMENT - 1) & ~(size_t) (DmInt_ARENA_ALIGNMENT - 1);
+}
+
+// The arena's memory is zeroed by Dm_alloc, so allocations from it don't need to be cleared one by one.
+DmResult DmArena_init(DmArena* slf, size_t capacity) {
+	if (slf == NULL) {
+		return DmResult_INVALID_ARGUMENT;
+	}
+
+	slf->data = NULL;
+	slf->capacity = 0;
+	slf->used = 0;
+	slf->overflow = NULL;
+
+	if (capacity == 0) {
+		return DmResult_SUCCESS;
+	}
+
+	slf->data = Dm_alloc(capacity);
+	if (slf->data == NULL) {
+		return DmResult_MEMORY_EXHAUSTED;
+	}
+
+	slf->capacity = capacity;
+	return DmResult_SUCCESS;
+}
+
+void DmArena_free(DmArena* slf) {
+	if (slf == NULL) {
+		return;
+	}
+
+	DmArenaBlock* block = slf->overflow;
+	while (block != NULL) {
+		DmArenaBlock* next = block->next;
+		Dm_free(block);
+		block = next;
+	}
+
+	Dm_free(slf->data);
+	slf->data = NULL;
+	slf->capacity = 0;
+	slf->used = 0;
+	slf->overflow = NULL;
+}
+
+void* DmArena_alloc(DmArena* slf, size_t len) {
+	if (slf == NULL) {
+		return NULL;
+	}
+
+	len = DmArena_measure(len);
+	size_t offset = atomic_fetch_add(&slf->used, len);
+	if (offset + len <= slf->capacity) {
+		return slf->data + offset;
+	}
+
+	// The block header is padded so that the allocation keeps the arena's alignment.
+	DmArenaBlock* block = Dm_alloc(DmArena_measure(sizeof *block) + len);
+	if (block == NULL) {
+		return NULL;
+	}
+
+	block->next = atomic_load(&slf->overflow);
+	while (!atomic_compare_exchange_weak(&slf->overflow, &block->next, block)) {
+	}
+
+	return (uint8_t*) block + DmArena_measure(sizeof *block);
+}
+
+// Allocations which don't fit are counted in `used` as well, so once the arena overflows, `used` includes them.
+size_t DmArena_getSize(DmArena* slf) {
+	if (slf == NULL) {
+		return 0;
+	}
+
+	return max_usize(slf->capacity, atomic_load(&slf->used));
+}
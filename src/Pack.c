@@ -0,0 +1,411 @@
+// Copyright © 2024. GothicKit Contributors
+// SPDX-License-Identifier: MIT-Modern-Variant
+#include "_Internal.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Pack files bundle many small files into one, so that they can be served from a single memory mapping. All
+// integers are stored in little-endian byte order. The layout is as follows:
+//
+//   header    magic[8], format (u32), entry_count (u32), names_offset (u64), names_length (u64)
+//   entries   offset (u64), length (u64), name_offset (u32), name_length (u32) for each entry
+//   names     the lower-case, NUL-terminated name of each entry
+//   data      the contents of each entry, aligned to DmInt_PACK_ALIGNMENT bytes
+//
+// Entries are sorted by name, so that they can be found using a binary search.
+
+enum {
+	DmInt_PACK_FORMAT = 1,
+	DmInt_PACK_ALIGNMENT = 16,
+	DmInt_PACK_HEADER_SIZE = 32,
+	DmInt_PACK_ENTRY_SIZE = 24,
+};
+
+static char const DmInt_PACK_MAGIC[8] = "DMPACK\0";
+
+struct DmPack {
+	_Atomic size_t reference_count;
+
+	uint8_t const* data;
+	size_t length;
+
+	uint32_t entry_count;
+	uint8_t const* entries;
+	char const* names;
+};
+
+static uint32_t DmPack_readU32(uint8_t const* buf) {
+	return (uint32_t) buf[0] | (uint32_t) buf[1] << 8 | (uint32_t) buf[2] << 16 | (uint32_t) buf[3] << 24;
+}
+
+static uint64_t DmPack_readU64(uint8_t const* buf) {
+	return (uint64_t) DmPack_readU32(buf) | (uint64_t) DmPack_readU32(buf + 4) << 32;
+}
+
+static void DmPack_writeU32(uint8_t* buf, uint32_t val) {
+	buf[0] = (uint8_t) val;
+	buf[1] = (uint8_t) (val >> 8);
+	buf[2] = (uint8_t) (val >> 16);
+	buf[3] = (uint8_t) (val >> 24);
+}
+
+static void DmPack_writeU64(uint8_t* buf, uint64_t val) {
+	DmPack_writeU32(buf, (uint32_t) val);
+	DmPack_writeU32(buf + 4, (uint32_t) (val >> 32));
+}
+
+// Compares a name from the pack, which is already lower-case, to a name of arbitrary case.
+static int DmPack_compareName(char const* packed, char const* name) {
+	for (;; ++packed, ++name) {
+		int a = (unsigned char) *packed;
+		int b = tolower((unsigned char) *name);
+
+		if (a != b || a == '\0') {
+			return a - b;
+		}
+	}
+}
+
+static bool DmPack_validate(DmPack* slf) {
+	if (slf->length < DmInt_PACK_HEADER_SIZE || memcmp(slf->data, DmInt_PACK_MAGIC, sizeof DmInt_PACK_MAGIC) != 0) {
+		return false;
+	}
+
+	if (DmPack_readU32(slf->data + 8) != DmInt_PACK_FORMAT) {
+		return false;
+	}
+
+	slf->entry_count = DmPack_readU32(slf->data + 12);
+	uint64_t names_offset = DmPack_readU64(slf->data + 16);
+	uint64_t names_length = DmPack_readU64(slf->data + 24);
+	uint64_t entries_end = DmInt_PACK_HEADER_SIZE + (uint64_t) slf->entry_count * DmInt_PACK_ENTRY_SIZE;
+
+	// Sizes are compared using subtraction, so that malformed offsets near UINT64_MAX cannot wrap around.
+	if (entries_end > names_offset || names_offset > slf->length || names_length > slf->length - names_offset) {
+		return false;
+	}
+
+	slf->entries = slf->data + DmInt_PACK_HEADER_SIZE;
+	slf->names = (char const*) slf->data + names_offset;
+
+	// Check every entry once, so that lookups don't need to.
+	for (uint32_t i = 0; i < slf->entry_count; ++i) {
+		uint8_t const* entry = slf->entries + (size_t) i * DmInt_PACK_ENTRY_SIZE;
+		uint64_t offset = DmPack_readU64(entry);
+		uint64_t length = DmPack_readU64(entry + 8);
+		uint64_t name_offset = DmPack_readU32(entry + 16);
+		uint64_t name_length = DmPack_readU32(entry + 20);
+
+		if (offset > slf->length || length > slf->length - offset || length == 0 || name_offset >= names_length ||
+		    name_length >= names_length - name_offset || slf->names[name_offset + name_length] != '\0') {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+DmResult DmPack_open(DmPack** slf, char const* path) {
+	if (slf == NULL || path == NULL) {
+		return DmResult_INVALID_ARGUMENT;
+	}
+
+	DmPack* new = *slf = Dm_alloc(sizeof *new);
+	if (new == NULL) {
+		return DmResult_MEMORY_EXHAUSTED;
+	}
+
+	new->reference_count = 1;
+	new->data = Dm_mapFile(path, &new->length);
+	if (new->data == NULL) {
+		Dm_free(new);
+		*slf = NULL;
+		return DmResult_NOT_FOUND;
+	}
+
+	if (!DmPack_validate(new)) {
+		Dm_report(DmLogLevel_ERROR, "DmPack: Pack file '%s' is corrupt", path);
+		DmPack_release(new);
+		*slf = NULL;
+		return DmResult_FILE_CORRUPT;
+	}
+
+	Dm_report(DmLogLevel_DEBUG, "DmPack: Opened '%s' with %u entries", path, new->entry_count);
+	return DmResult_SUCCESS;
+}
+
+DmPack* DmPack_retain(DmPack* slf) {
+	if (slf == NULL) {
+		return NULL;
+	}
+
+	(void) atomic_fetch_add(&slf->reference_count, 1);
+	return slf;
+}
+
+void DmPack_release(void* ctx) {
+	DmPack* slf = ctx;
+	if (slf == NULL) {
+		return;
+	}
+
+	size_t refs = atomic_fetch_sub(&slf->reference_count, 1) - 1;
+	if (refs > 0) {
+		return;
+	}
+
+	Dm_unmapFile(NULL, (void*) slf->data, slf->length);
+	Dm_free(slf);
+}
+
+// Buffers returned by the resolver each hold a reference to the pack, so that objects loaded from it may outlive
+// the loader.
+static void DmPack_releaseBuffer(void* ctx, void* buf, size_t len) {
+	(void) buf;
+	(void) len;
+	DmPack_release(ctx);
+}
+
+void* DmPack_resolve(void* ctx,
+                     char const* file,
+                     size_t* len,
+                     DmLoaderBufferRelease** release,
+                     void** release_ctx) {
+	DmPack* slf = ctx;
+	if (slf == NULL || file == NULL) {
+		return NULL;
+	}
+
+	// Packs are flat, so only the last component of the requested path is considered.
+	for (char const* it = file; *it != '\0'; ++it) {
+		if (*it == '/' || *it == '\\') {
+			file = it + 1;
+		}
+	}
+
+	size_t lo = 0;
+	size_t hi = slf->entry_count;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		uint8_t const* entry = slf->entries + mid * DmInt_PACK_ENTRY_SIZE;
+
+		int cmp = DmPack_compareName(slf->names + DmPack_readU32(entry + 16), file);
+		if (cmp < 0) {
+			lo = mid + 1;
+		} else if (cmp > 0) {
+			hi = mid;
+		} else {
+			*len = (size_t) DmPack_readU64(entry + 8);
+			*release = DmPack_releaseBuffer;
+			*release_ctx = DmPack_retain(slf);
+
+			// The library never writes to resolved buffers, so handing out the read-only mapping is fine.
+			return (void*) (slf->data + DmPack_readU64(entry));
+		}
+	}
+
+	return NULL;
+}
+
+typedef struct DmPackSource {
+	char* name;
+	char const* path;
+	uint64_t offset;
+	size_t length;
+} DmPackSource;
+
+typedef struct DmPackSourceList {
+	DmPackSource* data;
+	size_t length;
+	DmResult result;
+} DmPackSourceList;
+
+static void DmPack_collect(void* ctx, char const* name, char const* path) {
+	DmPackSourceList* list = ctx;
+	if (list->result != DmResult_SUCCESS) {
+		return;
+	}
+
+	size_t name_len = strlen(name);
+	char* lower = Dm_alloc(name_len + 1);
+	if (lower == NULL) {
+		list->result = DmResult_MEMORY_EXHAUSTED;
+		return;
+	}
+
+	for (size_t i = 0; i <= name_len; ++i) {
+		lower[i] = (char) tolower((unsigned char) name[i]);
+	}
+
+	DmPackSource* src = &list->data[list->length++];
+	src->name = lower;
+	src->path = path;
+}
+
+static int DmPack_compareSources(void const* a, void const* b) {
+	return strcmp(((DmPackSource const*) a)->name, ((DmPackSource const*) b)->name);
+}
+
+static bool DmPack_writeBytes(FILE* fp, void const* data, size_t len) {
+	return len == 0 || fwrite(data, 1, len, fp) == len;
+}
+
+static bool DmPack_writeContents(FILE* fp, DmPackSourceList* list, uint64_t names_offset, uint64_t names_length) {
+	uint8_t buf[DmInt_PACK_HEADER_SIZE];
+	memcpy(buf, DmInt_PACK_MAGIC, sizeof DmInt_PACK_MAGIC);
+	DmPack_writeU32(buf + 8, DmInt_PACK_FORMAT);
+	DmPack_writeU32(buf + 12, (uint32_t) list->length);
+	DmPack_writeU64(buf + 16, names_offset);
+	DmPack_writeU64(buf + 24, names_length);
+
+	if (!DmPack_writeBytes(fp, buf, sizeof buf)) {
+		return false;
+	}
+
+	uint32_t name_offset = 0;
+	for (size_t i = 0; i < list->length; ++i) {
+		DmPackSource* src = &list->data[i];
+		uint32_t name_length = (uint32_t) strlen(src->name);
+
+		DmPack_writeU64(buf, src->offset);
+		DmPack_writeU64(buf + 8, src->length);
+		DmPack_writeU32(buf + 16, name_offset);
+		DmPack_writeU32(buf + 20, name_length);
+
+		if (!DmPack_writeBytes(fp, buf, DmInt_PACK_ENTRY_SIZE)) {
+			return false;
+		}
+
+		name_offset += name_length + 1;
+	}
+
+	for (size_t i = 0; i < list->length; ++i) {
+		if (!DmPack_writeBytes(fp, list->data[i].name, strlen(list->data[i].name) + 1)) {
+			return false;
+		}
+	}
+
+	static uint8_t const padding[DmInt_PACK_ALIGNMENT] = {0};
+	uint64_t position = names_offset + names_length;
+
+	for (size_t i = 0; i < list->length; ++i) {
+		DmPackSource* src = &list->data[i];
+		if (!DmPack_writeBytes(fp, padding, (size_t) (src->offset - position))) {
+			return false;
+		}
+
+		size_t len = 0;
+		void* data = Dm_mapFile(src->path, &len);
+		if (data == NULL || len != src->length) {
+			Dm_report(DmLogLevel_ERROR, "DmPack: Failed to read '%s'", src->path);
+			Dm_unmapFile(NULL, data, len);
+			return false;
+		}
+
+		bool ok = DmPack_writeBytes(fp, data, len);
+		Dm_unmapFile(NULL, data, len);
+
+		if (!ok) {
+			return false;
+		}
+
+		position = src->offset + src->length;
+	}
+
+	return true;
+}
+
+DmResult Dm_writePack(char const* directory, char const* output) {
+	if (directory == NULL || output == NULL) {
+		return DmResult_INVALID_ARGUMENT;
+	}
+
+	DmDirectory* dir = NULL;
+	DmResult rv = DmDirectory_open(&dir, directory);
+	if (rv != DmResult_SUCCESS) {
+		Dm_report(DmLogLevel_ERROR, "DmPack: Failed to open directory '%s'", directory);
+		return rv;
+	}
+
+	DmPackSourceList list;
+	list.length = 0;
+	list.result = DmResult_SUCCESS;
+	list.data = Dm_alloc(DmDirectory_getFileCount(dir) * sizeof *list.data + 1);
+
+	if (list.data == NULL) {
+		DmDirectory_close(dir);
+		return DmResult_MEMORY_EXHAUSTED;
+	}
+
+	DmDirectory_visit(dir, DmPack_collect, &list);
+	rv = list.result;
+
+	if (rv != DmResult_SUCCESS) {
+		for (size_t i = 0; i < list.length; ++i) {
+			Dm_free(list.data[i].name);
+		}
+
+		Dm_free(list.data);
+		DmDirectory_close(dir);
+		return rv;
+	}
+
+	qsort(list.data, list.length, sizeof *list.data, DmPack_compareSources);
+
+	// Determine the size and position of every file. Files which are not regular files, like sub-directories, are
+	// skipped, and so are files whose names only differ in case.
+	size_t kept = 0;
+	uint64_t names_length = 0;
+	for (size_t i = 0; i < list.length; ++i) {
+		DmPackSource* src = &list.data[i];
+		void* data = Dm_mapFile(src->path, &src->length);
+
+		if (data == NULL || (kept > 0 && strcmp(list.data[kept - 1].name, src->name) == 0)) {
+			Dm_report(DmLogLevel_WARN, "DmPack: Skipping '%s'", src->path);
+			Dm_unmapFile(NULL, data, src->length);
+			Dm_free(src->name);
+			continue;
+		}
+
+		Dm_unmapFile(NULL, data, src->length);
+		names_length += strlen(src->name) + 1;
+		list.data[kept++] = *src;
+	}
+
+	list.length = kept;
+
+	uint64_t names_offset = DmInt_PACK_HEADER_SIZE + (uint64_t) list.length * DmInt_PACK_ENTRY_SIZE;
+	uint64_t position = names_offset + names_length;
+	for (size_t i = 0; i < list.length; ++i) {
+		position = (position + DmInt_PACK_ALIGNMENT - 1) / DmInt_PACK_ALIGNMENT * DmInt_PACK_ALIGNMENT;
+		list.data[i].offset = position;
+		position += list.data[i].length;
+	}
+
+	FILE* fp = fopen(output, "wb");
+	if (fp == NULL) {
+		Dm_report(DmLogLevel_ERROR, "DmPack: Failed to create '%s'", output);
+		rv = DmResult_NOT_FOUND;
+	} else {
+		bool ok = DmPack_writeContents(fp, &list, names_offset, names_length);
+		ok = fclose(fp) == 0 && ok;
+
+		if (!ok) {
+			Dm_report(DmLogLevel_ERROR, "DmPack: Failed to write '%s'", output);
+			(void) remove(output);
+			rv = DmResult_FILE_CORRUPT;
+		} else {
+			Dm_report(DmLogLevel_INFO, "DmPack: Wrote %zu files to '%s'", list.length, output);
+		}
+	}
+
+	for (size_t i = 0; i < list.length; ++i) {
+		Dm_free(list.data[i].name);
+	}
+
+	Dm_free(list.data);
+	DmDirectory_close(dir);
+	return rv;
+}
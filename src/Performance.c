@@ -3,17 +3,25 @@
 #include "_Internal.h"
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
 #ifndef M_PI
 	#define M_PI 3.14159
 #endif
 
 enum {
+	DmInt_MIDI_CC_VOLUME = 7,
+	DmInt_MIDI_CC_PAN = 10,
+	DmInt_MIDI_MAX = 127,
+
 	DmInt_DEFAULT_TEMPO = 100,
 	DmInt_DEFAULT_SAMPLE_RATE = 44100,
 	DmInt_DEFAULT_SCALE_PATTERN = 0xab5ab5,
+	DmInt_TRANSITION_CACHE_MAX = 16,
 };
 
+static void DmPerformance_setChord(DmPerformance* slf, DmMessage_Chord const* chord);
+
 DmResult DmPerformance_create(DmPerformance** slf, uint32_t rate) {
 	if (slf == NULL) {
 		return DmResult_INVALID_ARGUMENT;
@@ -33,6 +41,10 @@ DmResult DmPerformance_create(DmPerformance** slf, uint32_t rate) {
 	new->time_signature.grids_per_beat = 2;
 
 	DmSynth_init(&new->synth, new->sample_rate);
+	DmRandom_init(&new->rng, ((uint64_t) Dm_rand() << 32) | Dm_rand());
+	DmTransitionCache_init(&new->transitions);
+	DmPartCursorList_init(&new->pattern_parts);
+	DmPerformance_setChord(new, &new->chord);
 
 	if (mtx_init(&new->lock, mtx_plain) != thrd_success) {
 		Dm_free(new);
@@ -83,6 +95,9 @@ void DmPerformance_release(DmPerformance* slf) {
 	DmStyle_release(slf->style);
 	DmBand_release(slf->band);
 	DmSynth_free(&slf->synth);
+	DmTransitionCache_free(&slf->transitions);
+	DmPartCursorList_free(&slf->pattern_parts);
+	DmStyle_release(slf->pattern_style);
 	Dm_free(slf);
 }
 
@@ -204,7 +219,7 @@ static uint32_t fixup_scale(uint32_t scale, uint8_t scale_root) {
 	return scale;
 }
 
-static int DmPerformance_musicValueToMidi(struct DmSubChord chord, DmPlayModeFlags mode, uint16_t value) {
+static int DmPerformance_musicValueToMidi(DmSubChordMap const* chord, DmPlayModeFlags mode, uint16_t value) {
 	uint32_t offset = 0;
 
 	// Make sure the octave is not negative. If it is, transpose it up, and save the note offset.
@@ -226,7 +241,7 @@ static int DmPerformance_musicValueToMidi(struct DmSubChord chord, DmPlayModeFla
 	uint16_t root = 0;
 
 	if (mode & DmPlayMode_CHORD_ROOT) {
-		root = chord.chord_root;
+		root = chord->chord_root;
 	} else if (mode & DmPlayMode_KEY_ROOT) {
 		Dm_report(DmLogLevel_DEBUG, "DmPerformance: DmPlayMode_KEY_ROOT requested but we don't support it");
 		return -1;
@@ -239,15 +254,8 @@ static int DmPerformance_musicValueToMidi(struct DmSubChord chord, DmPlayModeFla
 		return -1;
 	}
 
-	// Make sure we actually have a scale to play from and fix it up (?)
-	// TODO: Why do we need to fixup the scale?
-	uint32_t scale_pattern = chord.scale_pattern ? chord.scale_pattern : DmInt_DEFAULT_SCALE_PATTERN;
-	scale_pattern = fixup_scale(scale_pattern, chord.scale_root);
-
-	uint32_t chord_pattern = chord.chord_pattern;
-	if (chord_pattern == 0) {
-		chord_pattern = 1;
-	}
+	uint32_t scale_pattern = chord->scale_pattern;
+	uint32_t chord_pattern = chord->chord_pattern;
 
 	uint16_t chord_position = (value & 0x0f00) >> 8;
 	uint16_t scale_position = (value & 0x0070) >> 4; // Make sure scale position < 8
@@ -263,7 +271,7 @@ static int DmPerformance_musicValueToMidi(struct DmSubChord chord, DmPlayModeFla
 	uint16_t note_position = 0;
 
 	uint16_t root_octave = root % 12;
-	uint16_t chord_bits = bit_count(chord_pattern);
+	uint16_t chord_bits = chord->chord_bits;
 
 	if ((mode & DmPlayMode_CHORD_INTERVALS) && scale_position == 0 && (chord_position < chord_bits)) {
 		note_offset = root + note_accidentals;
@@ -340,51 +348,85 @@ static int DmPerformance_musicValueToMidi(struct DmSubChord chord, DmPlayModeFla
 	return note_value;
 }
 
-#define DmInt_CURVE_SPACING 5
+// Prepare the sub-chords of the given chord for mapping music values to MIDI notes. This only needs to be done once
+// for every chord change instead of once for every note.
+static void DmPerformance_setChord(DmPerformance* slf, DmMessage_Chord const* chord) {
+	slf->chord = *chord;
 
-static DmResult DmPattern_generateNoteMessages(DmPart* part,
-                                               struct DmSubChord chord,
-                                               uint32_t time,
-                                               uint32_t variation,
-                                               uint32_t channel,
-                                               DmMessageQueue* out) {
-	// Now we are ready to create all the note on/note off messages
-	// for this pattern
-	for (size_t j = 0; j < part->note_count; ++j) {
-		DmNote note = part->notes[j];
+	for (size_t i = 0; i < 4; ++i) {
+		struct DmSubChord const* sub = &chord->subchords[i];
+		DmSubChordMap* map = &slf->chord_map[i];
 
-		// We ignore notes which do not correspond to the selected variation
-		if (!(note.variation & variation)) {
-			continue;
+		// Make sure we actually have a scale to play from and fix it up (?)
+		// TODO: Why do we need to fixup the scale?
+		uint32_t scale_pattern = sub->scale_pattern ? sub->scale_pattern : DmInt_DEFAULT_SCALE_PATTERN;
+		map->scale_pattern = fixup_scale(scale_pattern, sub->scale_root);
+
+		map->chord_pattern = sub->chord_pattern;
+		if (map->chord_pattern == 0) {
+			map->chord_pattern = 1;
+		}
+
+		map->chord_bits = bit_count(map->chord_pattern);
+		map->chord_root = sub->chord_root;
+		map->levels = sub->levels;
+	}
+}
+
+// Map a note-on message's music value to a MIDI note using the chord currently playing. Returns -1 if the
+// music value can not be mapped.
+static int DmPerformance_mapNote(DmPerformance* slf, DmMessage_Note const* note) {
+	if (note->play_mode == DmPlayMode_FIXED) {
+		return note->music_value;
+	}
+
+	// Now we need to select the correct sub-chord to use for the note by comparing against the sub-chord level
+	// of the part. By default, we just use the first one.
+	DmSubChordMap const* map = &slf->chord_map[0];
+	for (size_t i = 0; i < slf->chord.subchord_count && i < 4; ++i) {
+		if (slf->chord_map[i].levels & (1 << note->subchord_level)) {
+			map = &slf->chord_map[i];
+			break;
 		}
+	}
 
-		DmPlayModeFlags flags = note.play_mode_flags == DmPlayMode_NONE ? part->play_mode_flags : note.play_mode_flags;
+	return DmPerformance_musicValueToMidi(map, note->play_mode, note->music_value);
+}
+
+#define DmInt_CURVE_SPACING 5
 
-		int midi = note.music_value;
-		if (flags != DmPlayMode_FIXED) {
-			midi = DmPerformance_musicValueToMidi(chord, flags, note.music_value);
+static DmResult
+DmPattern_generateNoteMessages(DmPartCursor* cur, DmRandom* rng, uint32_t time, uint32_t end, DmMessageQueue* out) {
+	// Now we are ready to create the note on messages for all notes of the part starting before `end`. The music
+	// values are mapped to MIDI notes when the messages are handled, so that chord changes within the pattern are
+	// taken into account.
+	DmPart* part = cur->part;
+	for (; cur->note < part->note_count; ++cur->note) {
+		DmNote const* note = &part->notes[cur->note];
+
+		if (note->offset >= end) {
+			break;
 		}
 
-		if (midi < 0) {
-			// We were unable to convert the music value
-			Dm_report(DmLogLevel_WARN, "DmPerformance: Unable to convert music value %d to MIDI", note.music_value);
+		// We ignore notes which do not correspond to the selected variation
+		if (!(note->variation & cur->variation)) {
 			continue;
 		}
 
-		uint32_t offset = Dm_getTimeOffset(note.grid_start, note.time_offset, part->time_signature);
+		uint32_t offset = note->offset;
 
-		if (note.time_range != 0) {
-			offset += Dm_randRange(note.time_range);
+		if (note->time_range != 0) {
+			offset += Dm_randRange(rng, note->time_range);
 		}
 
-		uint32_t duration = note.duration;
-		if (note.duration_range != 0) {
-			offset += Dm_randRange(note.duration_range);
+		uint32_t duration = note->duration;
+		if (note->duration_range != 0) {
+			offset += Dm_randRange(rng, note->duration_range);
 		}
 
-		uint32_t velocity = note.velocity;
-		if (note.velocity_range != 0) {
-			offset += Dm_randRange(note.velocity_range);
+		uint32_t velocity = note->velocity;
+		if (note->velocity_range != 0) {
+			offset += Dm_randRange(rng, note->velocity_range);
 		}
 
 		DmMessage msg;
@@ -392,22 +434,18 @@ static DmResult DmPattern_generateNoteMessages(DmPart* part,
 		msg.time = 0;
 
 		msg.note.on = true;
-		msg.note.note = (uint8_t) midi;
+		msg.note.note = 0;
 		msg.note.velocity = (uint8_t) velocity;
-		msg.note.channel = channel;
+		msg.note.channel = cur->channel;
+		msg.note.music_value = note->music_value;
+		msg.note.play_mode = note->play_mode_flags;
+		msg.note.subchord_level = cur->subchord_level;
+		msg.note.duration = duration;
 
 		DmResult rv = DmMessageQueue_add(out, &msg, time + offset, DmQueueConflict_APPEND);
 		if (rv != DmResult_SUCCESS) {
 			return rv;
 		}
-
-		msg.note.on = false;
-		msg.note.note = (uint8_t) midi;
-
-		rv = DmMessageQueue_add(out, &msg, time + offset + duration, DmQueueConflict_APPEND);
-		if (rv != DmResult_SUCCESS) {
-			return rv;
-		}
 	}
 
 	return DmResult_SUCCESS;
@@ -506,20 +544,22 @@ static DmResult DmPattern_generatePitchBendCurve(DmCurve* curve, uint32_t time,
 	return DmResult_SUCCESS;
 }
 
-static DmResult DmPattern_generateCurveMessages(DmPart* part,
-                                                uint32_t time,
-                                                uint32_t variation,
-                                                uint32_t channel,
-                                                DmMessageQueue* out) {
-	for (size_t j = 0; j < part->curve_count; ++j) {
-		DmCurve curve = part->curves[j];
+static DmResult DmPattern_generateCurveMessages(DmPartCursor* cur, uint32_t time, uint32_t end, DmMessageQueue* out) {
+	DmPart* part = cur->part;
+	for (; cur->curve < part->curve_count; ++cur->curve) {
+		DmCurve curve = part->curves[cur->curve];
 
-		// We ignore notes which do not correspond to the selected variation
-		if (!(curve.variation & variation)) {
+		if (curve.offset >= end) {
+			break;
+		}
+
+		// We ignore curves which do not correspond to the selected variation
+		if (!(curve.variation & cur->variation)) {
 			continue;
 		}
 
-		uint32_t start = Dm_getTimeOffset(curve.grid_start, curve.time_offset, part->time_signature);
+		uint32_t start = curve.offset;
+		uint32_t channel = cur->channel;
 
 		DmResult rv = DmResult_SUCCESS;
 		switch (curve.event_type) {
@@ -547,15 +587,15 @@ static DmResult DmPattern_generateCurveMessages(DmPart* part,
 	return DmResult_SUCCESS;
 }
 
-static DmResult DmPattern_generateMessages(DmPattern* slf,
-                                           DmStyle* sty,
-                                           DmMessage_Chord* chord,
-                                           uint32_t time,
-                                           uint32_t seq,
-                                           DmMessageQueue* out) {
+// Select the parts and variations to play for a pattern. Their messages are generated later by
+// DmPerformance_generatePatternMeasure.
+static DmResult
+DmPattern_selectParts(DmPattern* slf, DmStyle* sty, DmRandom* rng, uint32_t seq, DmPartCursorList* out) {
 	int64_t variation[UINT8_MAX + 1];
 	memset(variation, -1, sizeof variation);
 
+	out->length = 0;
+
 	// 1. Select the variation IDs for each part
 	for (size_t i = 0; i < slf->parts.length; ++i) {
 		DmPartReference* pref = &slf->parts.data[i];
@@ -574,7 +614,7 @@ static DmResult DmPattern_generateMessages(DmPattern* slf,
 				variation[pref->variation_lock_id] = seq;
 				break;
 			case DmVariation_RANDOM:
-				variation[pref->variation_lock_id] = Dm_rand();
+				variation[pref->variation_lock_id] = DmRandom_next(rng);
 				break;
 			case DmVariation_RANDOM_START:
 				// TODO(lmichaelis): Implement this correctly. To do that, we need to store the previous
@@ -584,7 +624,7 @@ static DmResult DmPattern_generateMessages(DmPattern* slf,
 			case DmVariation_NO_REPEAT:
 				// TODO(lmichaelis): Implement this correctly. To do that, we need to store the previous
 				//                   variation id for each pattern somewhere and compare it to the next value
-				variation[pref->variation_lock_id] = Dm_rand();
+				variation[pref->variation_lock_id] = DmRandom_next(rng);
 				break;
 			}
 		}
@@ -592,30 +632,134 @@ static DmResult DmPattern_generateMessages(DmPattern* slf,
 		uint32_t variation_id = (uint32_t) variation[pref->variation_lock_id];
 		variation_id = 1 << (variation_id % DmPart_getValidVariationCount(part));
 
-		// Now we need to select the correct sub-chord to use for the pattern
-		// by comparing against the sub-chord level of the pattern. By default,
-		// we just use the first one.
-		struct DmSubChord level = chord->subchords[0];
-		for (size_t j = 0; j < chord->subchord_count; ++j) {
-			if (chord->subchords[j].levels & (1 << pref->subchord_level)) {
-				level = chord->subchords[j];
-				break;
-			}
+		DmPartCursor cur;
+		cur.part = part;
+		cur.variation = variation_id;
+		cur.channel = pref->logical_part_id;
+		cur.subchord_level = pref->subchord_level;
+		cur.note = 0;
+		cur.curve = 0;
+
+		DmResult rv = DmPartCursorList_add(out, cur);
+		if (rv != DmResult_SUCCESS) {
+			return rv;
 		}
+	}
+
+	return DmResult_SUCCESS;
+}
+
+// Generate the messages for the next measure of the playing pattern and schedule the generation of the measure after
+// it. Messages are always generated one measure ahead of time.
+static DmResult DmPerformance_generatePatternMeasure(DmPerformance* slf) {
+	uint32_t measure_length = Dm_getMeasureLength(slf->time_signature);
+	uint32_t measure = slf->pattern_measure++;
+
+	// The last measure also includes all events which extend past the end of the pattern.
+	uint32_t end = measure_length * (measure + 1);
+	if (slf->pattern_measure >= slf->pattern_measures) {
+		end = UINT32_MAX;
+	}
+
+	for (size_t i = 0; i < slf->pattern_parts.length; ++i) {
+		DmPartCursor* cur = &slf->pattern_parts.data[i];
 
-		// Now we can create the actual messages for the pattern.
-		DmResult rv = DmPattern_generateNoteMessages(part, level, time, variation_id, pref->logical_part_id, out);
+		DmResult rv = DmPattern_generateNoteMessages(cur, &slf->rng, slf->pattern_start, end, &slf->music_queue);
 		if (rv != DmResult_SUCCESS) {
 			return rv;
 		}
 
-		rv = DmPattern_generateCurveMessages(part, time, variation_id, pref->logical_part_id, out);
+		rv = DmPattern_generateCurveMessages(cur, slf->pattern_start, end, &slf->music_queue);
 		if (rv != DmResult_SUCCESS) {
 			return rv;
 		}
 	}
 
-	return DmResult_SUCCESS;
+	if (slf->pattern_measure >= slf->pattern_measures) {
+		return DmResult_SUCCESS;
+	}
+
+	DmMessage msg;
+	msg.type = DmMessage_PATTERN;
+	msg.time = 0;
+
+	return DmMessageQueue_add(&slf->music_queue,
+	                          &msg,
+	                          slf->pattern_start + measure * measure_length,
+	                          DmQueueConflict_APPEND);
+}
+
+static void DmPerformance_emitEvent(DmPerformance* slf, DmEvent* evt) {
+	evt->frame = slf->event_frame;
+	evt->time = slf->time;
+	slf->event_callback(slf->event_context, evt);
+}
+
+static void DmPerformance_sendNoteOffEverything(DmPerformance* slf, bool reset) {
+	if (slf->event_callback == NULL) {
+		DmSynth_sendNoteOffEverything(&slf->synth);
+
+		if (reset) {
+			DmSynth_reset(&slf->synth);
+		}
+		return;
+	}
+
+	DmEvent evt;
+	memset(&evt, 0, sizeof evt);
+	evt.type = DmEvent_NOTE_OFF_ALL;
+	DmPerformance_emitEvent(slf, &evt);
+
+	if (reset) {
+		evt.type = DmEvent_RESET;
+		DmPerformance_emitEvent(slf, &evt);
+	}
+}
+
+static void DmPerformance_sendBandUpdate(DmPerformance* slf, DmBand* band) {
+	if (slf->event_callback == NULL) {
+		DmSynth_sendBandUpdate(&slf->synth, band);
+		return;
+	}
+
+	// Like the synthesizer, pan and volume set by a band also become the channel's reset values. They are sent even if
+	// the band does not change the channel's instrument.
+	DmEvent evt;
+	for (size_t i = 0; i < band->instruments_len; ++i) {
+		DmInstrument* ins = &band->instruments[i];
+
+		if (ins->options & (DmInstrument_VALID_PATCH | DmInstrument_VALID_BANKSELECT)) {
+			memset(&evt, 0, sizeof evt);
+			evt.type = DmEvent_PROGRAM;
+			evt.channel = ins->channel;
+			evt.bank = (uint8_t) ((ins->patch & 0xFF00U) >> 8);
+			evt.preset = (uint8_t) (ins->patch & 0xFFU);
+			evt.transpose = ins->options & DmInstrument_VALID_TRANSPOSE ? ins->transpose : 0;
+			DmPerformance_emitEvent(slf, &evt);
+		}
+
+		if (ins->options & DmInstrument_VALID_PAN) {
+			memset(&evt, 0, sizeof evt);
+			evt.type = DmEvent_CONTROL;
+			evt.channel = ins->channel;
+			evt.control = DmInt_MIDI_CC_PAN;
+			evt.value = (float) ins->pan / (float) DmInt_MIDI_MAX;
+			evt.reset = 1;
+			evt.reset_value = evt.value;
+			DmPerformance_emitEvent(slf, &evt);
+		}
+
+		if (ins->options & DmInstrument_VALID_VOLUME) {
+			memset(&evt, 0, sizeof evt);
+			evt.type = DmEvent_CONTROL;
+			evt.channel = ins->channel;
+			evt.control = DmInt_MIDI_CC_VOLUME;
+			evt.value = (float) ins->volume / (float) DmInt_MIDI_MAX;
+			evt.reset = 1;
+			evt.reset_value = evt.value;
+			DmPerformance_emitEvent(slf, &evt);
+		}
+	}
 }
 
 static DmResult DmPerformance_playPattern(DmPerformance* slf, DmPattern* pttn) {
@@ -627,12 +771,21 @@ static DmResult DmPerformance_playPattern(DmPerformance* slf, DmPattern* pttn) {
 
 	// Stop any already playing pattern.
 	DmMessageQueue_clear(&slf->music_queue);
-	DmSynth_sendNoteOffEverything(&slf->synth);
-	DmSynth_reset(&slf->synth);
+	DmPerformance_sendNoteOffEverything(slf, true);
 
-	// Generate the new pattern's messages
-	DmResult rv =
-	    DmPattern_generateMessages(pttn, slf->style, &slf->chord, slf->time, slf->variation, &slf->music_queue);
+	// Select the new pattern's parts and generate the messages for its first measure
+	DmResult rv = DmPattern_selectParts(pttn, slf->style, &slf->rng, slf->variation, &slf->pattern_parts);
+	if (rv != DmResult_SUCCESS) {
+		return rv;
+	}
+
+	DmStyle_release(slf->pattern_style);
+	slf->pattern_style = DmStyle_retain(slf->style);
+	slf->pattern_start = slf->time;
+	slf->pattern_measure = 0;
+	slf->pattern_measures = pttn->length_measures;
+
+	rv = DmPerformance_generatePatternMeasure(slf);
 	if (rv != DmResult_SUCCESS) {
 		return rv;
 	}
@@ -666,14 +819,14 @@ static void DmPerformance_handleCommandMessage(DmPerformance* slf, DmMessage_Com
 
 		// Randomize the groove level
 		if (msg->groove_range != 0) {
-			int32_t new_groove = slf->groove + Dm_randRange(msg->groove_range);
+			int32_t new_groove = slf->groove + Dm_randRange(&slf->rng, msg->groove_range);
 			slf->groove = clamp_s32(new_groove, 0, 100);
 		}
 	} else if (msg->command == DmCommand_END_AND_INTRO) {
 		Dm_report(DmLogLevel_WARN, "DmPerformance: Command message with command %d not implemented", msg->command);
 	}
 
-	DmPattern* pttn = DmStyle_getRandomPattern(slf->style, slf->groove, msg->command);
+	DmPattern* pttn = DmStyle_getRandomPattern(slf->style, &slf->rng, slf->groove, msg->command);
 	if (pttn == NULL) {
 		Dm_report(DmLogLevel_INFO, "DmPerformance: No suitable pattern found. Silence ensues ...", msg->command);
 		return;
@@ -682,6 +835,23 @@ static void DmPerformance_handleCommandMessage(DmPerformance* slf, DmMessage_Com
 	DmPerformance_playPattern(slf, pttn);
 }
 
+// Transitions composed with another style can only be re-used once that style plays again, so they are released
+// instead of keeping the style, its bands and the target segments loaded.
+static void DmPerformance_pruneTransitions(DmPerformance* slf) {
+	size_t kept = 0;
+	for (size_t i = 0; i < slf->transitions.length; ++i) {
+		DmTransitionCacheEntry* entry = &slf->transitions.data[i];
+		if (entry->style != slf->style) {
+			DmSegment_release(entry->transition);
+			continue;
+		}
+
+		slf->transitions.data[kept++] = *entry;
+	}
+
+	slf->transitions.length = kept;
+}
+
 static void DmPerformance_handleSegmentMessage(DmPerformance* slf, DmMessage_SegmentChange* msg) {
 	DmSegment* sgt = msg->segment;
 	DmSegment_release(slf->segment);
@@ -689,7 +859,7 @@ static void DmPerformance_handleSegmentMessage(DmPerformance* slf, DmMessage_Seg
 	// Get rid of the currently playing segment.
 	DmMessageQueue_clear(&slf->control_queue);
 	DmMessageQueue_clear(&slf->music_queue);
-	DmSynth_sendNoteOffEverything(&slf->synth);
+	DmPerformance_sendNoteOffEverything(slf, false);
 
 	// If a `NULL`-segment is provided, simply stop the playing segment!
 	if (sgt == NULL) {
@@ -700,6 +870,8 @@ static void DmPerformance_handleSegmentMessage(DmPerformance* slf, DmMessage_Seg
 		slf->style = NULL;
 		slf->segment = NULL;
 		slf->band = NULL;
+
+		DmPerformance_pruneTransitions(slf);
 		return;
 	}
 
@@ -794,7 +966,7 @@ static void DmPerformance_handleMessage(DmPerformance* slf, DmMessage* msg) {
 
 		DmBand_release(slf->band);
 		slf->band = DmBand_retain(msg->band.band);
-		DmSynth_sendBandUpdate(&slf->synth, msg->band.band);
+		DmPerformance_sendBandUpdate(slf, msg->band.band);
 		break;
 	case DmMessage_TEMPO:
 		Dm_report(DmLogLevel_TRACE,
@@ -804,6 +976,9 @@ static void DmPerformance_handleMessage(DmPerformance* slf, DmMessage* msg) {
 
 		slf->tempo = msg->tempo.tempo;
 		break;
+	case DmMessage_PATTERN:
+		(void) DmPerformance_generatePatternMeasure(slf);
+		break;
 	case DmMessage_COMMAND:
 		Dm_report(DmLogLevel_TRACE,
 		          "DmPerformance(Message): time=%d type=command-change value=%d groove=%d groove-range=%d",
@@ -820,9 +995,30 @@ static void DmPerformance_handleMessage(DmPerformance* slf, DmMessage* msg) {
 		          slf->time,
 		          msg->chord.name);
 
-		slf->chord = msg->chord;
+		DmPerformance_setChord(slf, &msg->chord);
 		break;
 	case DmMessage_NOTE:
+		if (msg->note.on) {
+			int midi = DmPerformance_mapNote(slf, &msg->note);
+			if (midi < 0) {
+				// We were unable to convert the music value
+				Dm_report(DmLogLevel_WARN,
+				          "DmPerformance: Unable to convert music value %d to MIDI",
+				          msg->note.music_value);
+				break;
+			}
+
+			msg->note.note = (uint8_t) midi;
+
+			// Schedule the matching note-off message now that we know which MIDI note is being played.
+			DmMessage off = *msg;
+			off.note.on = false;
+			(void) DmMessageQueue_add(&slf->music_queue,
+			                          &off,
+			                          msg->time + msg->note.duration,
+			                          DmQueueConflict_APPEND);
+		}
+
 		Dm_report(DmLogLevel_TRACE,
 		          "DmPerformance(Message): time=%d type=note-%s channel=%d value=%d velocity=%d",
 		          slf->time,
@@ -831,7 +1027,15 @@ static void DmPerformance_handleMessage(DmPerformance* slf, DmMessage* msg) {
 		          msg->note.note,
 		          msg->note.velocity);
 
-		if (msg->note.on) {
+		if (slf->event_callback != NULL) {
+			DmEvent evt;
+			memset(&evt, 0, sizeof evt);
+			evt.type = msg->note.on ? DmEvent_NOTE_ON : DmEvent_NOTE_OFF;
+			evt.channel = msg->note.channel;
+			evt.note = msg->note.note;
+			evt.velocity = msg->note.velocity;
+			DmPerformance_emitEvent(slf, &evt);
+		} else if (msg->note.on) {
 			DmSynth_sendNoteOn(&slf->synth, msg->note.channel, msg->note.note, msg->note.velocity);
 		} else {
 			DmSynth_sendNoteOff(&slf->synth, msg->note.channel, msg->note.note);
@@ -845,6 +1049,19 @@ static void DmPerformance_handleMessage(DmPerformance* slf, DmMessage* msg) {
 		          msg->control.control,
 		          msg->control.value);
 
+		if (slf->event_callback != NULL) {
+			DmEvent evt;
+			memset(&evt, 0, sizeof evt);
+			evt.type = DmEvent_CONTROL;
+			evt.channel = msg->control.channel;
+			evt.control = msg->control.control;
+			evt.value = msg->control.value;
+			evt.reset = 1;
+			evt.reset_value = msg->control.reset ? msg->control.reset_value : msg->control.value;
+			DmPerformance_emitEvent(slf, &evt);
+			break;
+		}
+
 		DmSynth_sendControl(&slf->synth, msg->control.channel, msg->control.control, msg->control.value);
 
 		if (msg->control.reset) {
@@ -861,6 +1078,18 @@ static void DmPerformance_handleMessage(DmPerformance* slf, DmMessage* msg) {
 		          msg->pitch_bend.channel,
 		          msg->pitch_bend.value);
 
+		if (slf->event_callback != NULL) {
+			DmEvent evt;
+			memset(&evt, 0, sizeof evt);
+			evt.type = DmEvent_PITCH_BEND;
+			evt.channel = msg->pitch_bend.channel;
+			evt.bend = msg->pitch_bend.value;
+			evt.reset = msg->pitch_bend.reset ? 1 : 0;
+			evt.reset_bend = msg->pitch_bend.reset_value;
+			DmPerformance_emitEvent(slf, &evt);
+			break;
+		}
+
 		DmSynth_sendPitchBend(&slf->synth, msg->pitch_bend.channel, msg->pitch_bend.value);
 		if (msg->pitch_bend.reset) {
 			DmSynth_sendPitchBendReset(&slf->synth, msg->pitch_bend.channel, msg->pitch_bend.reset_value);
@@ -873,24 +1102,14 @@ static void DmPerformance_handleMessage(DmPerformance* slf, DmMessage* msg) {
 	}
 }
 
-DmResult DmPerformance_renderPcm(DmPerformance* slf, void* buf, size_t len, DmRenderOptions opts) {
-	if (slf == NULL || buf == NULL) {
-		return DmResult_INVALID_ARGUMENT;
-	}
-
-	if ((opts & DmRender_STEREO) && (len % 2 != 0)) {
-		return DmResult_INVALID_ARGUMENT;
-	}
-
+// Advance the performance by `len` samples, handling all messages which occur in that timeframe. If `buf` is `NULL`,
+// no PCM is synthesized. The caller must hold the performance lock.
+static void DmPerformance_advance(DmPerformance* slf, void* buf, size_t len, DmRenderOptions opts) {
 	uint8_t const channels = opts & DmRender_STEREO ? 2 : 1;
 
 	DmMessage msg_ctrl;
 	DmMessage msg_midi;
 
-	if (mtx_lock(&slf->lock) != thrd_success) {
-		return DmResult_MUTEX_ERROR;
-	}
-
 	size_t sample = 0;
 	while (sample < len) {
 
@@ -935,7 +1154,7 @@ DmResult DmPerformance_renderPcm(DmPerformance* slf, void* buf, size_t len, DmRe
 
 		// Render the samples from now until the message occurs and advance the buffer pointer
 		// and time and sample counters.
-		if (offset_samples > 0) {
+		if (offset_samples > 0 && buf != NULL) {
 			size_t bytes_rendered = DmSynth_render(&slf->synth, buf, offset_samples, opts);
 			buf = (uint8_t*) buf + bytes_rendered;
 		}
@@ -950,18 +1169,134 @@ DmResult DmPerformance_renderPcm(DmPerformance* slf, void* buf, size_t len, DmRe
 			DmMessageQueue_pop(&slf->music_queue);
 		}
 
+		slf->event_frame = (uint32_t) (sample / channels);
 		DmPerformance_handleMessage(slf, &msg);
 		DmMessage_free(&msg);
 	}
 
-	(void) mtx_unlock(&slf->lock);
-
 	// Render the remaining samples
 	uint32_t remaining_samples = (uint32_t) (len - sample);
-	(void) DmSynth_render(&slf->synth, buf, remaining_samples, opts);
+	if (buf != NULL) {
+		(void) DmSynth_render(&slf->synth, buf, remaining_samples, opts);
+	}
+
 	slf->time +=
 	    Dm_getDurationForSampleCount(remaining_samples, slf->time_signature, slf->tempo, slf->sample_rate, channels);
+}
+
+DmResult DmPerformance_renderPcm(DmPerformance* slf, void* buf, size_t len, DmRenderOptions opts) {
+	if (slf == NULL || buf == NULL) {
+		return DmResult_INVALID_ARGUMENT;
+	}
 
+	if ((opts & DmRender_STEREO) && (len % 2 != 0)) {
+		return DmResult_INVALID_ARGUMENT;
+	}
+
+	if (mtx_lock(&slf->lock) != thrd_success) {
+		return DmResult_MUTEX_ERROR;
+	}
+
+	DmPerformance_advance(slf, buf, len, opts);
+
+	(void) mtx_unlock(&slf->lock);
+	return DmResult_SUCCESS;
+}
+
+static void DmPerformance_ignoreEvent(void* ctx, DmEvent const* evt) {
+	(void) ctx;
+	(void) evt;
+}
+
+DmResult DmPerformance_renderEvents(DmPerformance* slf, size_t num, DmEventCallback* cb, void* ctx) {
+	if (slf == NULL) {
+		return DmResult_INVALID_ARGUMENT;
+	}
+
+	if (mtx_lock(&slf->lock) != thrd_success) {
+		return DmResult_MUTEX_ERROR;
+	}
+
+	slf->event_callback = cb != NULL ? cb : DmPerformance_ignoreEvent;
+	slf->event_context = ctx;
+
+	DmPerformance_advance(slf, NULL, num, 0);
+
+	slf->event_callback = NULL;
+	slf->event_context = NULL;
+
+	(void) mtx_unlock(&slf->lock);
+	return DmResult_SUCCESS;
+}
+
+static bool DmPerformance_chordEquals(DmMessage_Chord const* a, DmMessage_Chord const* b) {
+	if (a->subchord_count != b->subchord_count || a->silent != b->silent || strcmp(a->name, b->name) != 0) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < a->subchord_count && i < 4; ++i) {
+		struct DmSubChord const* x = &a->subchords[i];
+		struct DmSubChord const* y = &b->subchords[i];
+		if (x->chord_pattern != y->chord_pattern || x->scale_pattern != y->scale_pattern ||
+		    x->inversion_points != y->inversion_points || x->levels != y->levels || x->chord_root != y->chord_root ||
+		    x->scale_root != y->scale_root) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Find a previously composed transition for the current style, band and chord into the given segment or compose and
+// cache a new one. The caller must hold the performance lock.
+static DmResult DmPerformance_getTransition(DmPerformance* slf,
+                                            DmSegment* sgt,
+                                            DmEmbellishmentType embellishment,
+                                            DmSegment** out) {
+	DmPerformance_pruneTransitions(slf);
+
+	DmSegment* transition = NULL;
+	for (size_t i = 0; i < slf->transitions.length; ++i) {
+		DmTransitionCacheEntry* entry = &slf->transitions.data[i];
+		if (entry->band == slf->band && entry->target == sgt && entry->embellishment == embellishment &&
+		    DmPerformance_chordEquals(&entry->chord, &slf->chord)) {
+			transition = entry->transition;
+			break;
+		}
+	}
+
+	if (transition == NULL) {
+		DmResult rv = Dm_composeTransition(slf->style, slf->band, &slf->chord, sgt, embellishment, &transition);
+		if (rv != DmResult_SUCCESS) {
+			DmSegment_release(transition);
+			return rv;
+		}
+
+		// Evict the oldest transition if the cache is full.
+		if (slf->transitions.length >= DmInt_TRANSITION_CACHE_MAX) {
+			DmSegment_release(slf->transitions.data[0].transition);
+			memmove(slf->transitions.data,
+			        slf->transitions.data + 1,
+			        (slf->transitions.length - 1) * sizeof *slf->transitions.data);
+			slf->transitions.length -= 1;
+		}
+
+		DmTransitionCacheEntry entry;
+		entry.style = slf->style;
+		entry.band = slf->band;
+		entry.target = sgt;
+		entry.embellishment = embellishment;
+		entry.chord = slf->chord;
+		entry.transition = transition;
+
+		rv = DmTransitionCache_add(&slf->transitions, entry);
+		if (rv != DmResult_SUCCESS) {
+			DmSegment_release(transition);
+			return rv;
+		}
+	}
+
+	*out = DmSegment_retain(transition);
 	return DmResult_SUCCESS;
 }
 
@@ -981,18 +1316,35 @@ DmPerformance_playTransition(DmPerformance* slf, DmSegment* sgt, DmEmbellishment
 		return DmResult_INVALID_ARGUMENT;
 	}
 
+	if (mtx_lock(&slf->lock) != thrd_success) {
+		return DmResult_MUTEX_ERROR;
+	}
+
 	DmSegment* transition = NULL;
-	DmResult rv = Dm_composeTransition(slf->style, slf->band, &slf->chord, sgt, embellishment, &transition);
+	DmResult rv = DmPerformance_getTransition(slf, sgt, embellishment, &transition);
+	(void) mtx_unlock(&slf->lock);
+
 	if (rv != DmResult_SUCCESS) {
 		return rv;
 	}
 
 	rv = DmPerformance_playSegment(slf, transition, timing);
-	if (rv != DmResult_SUCCESS) {
-		return rv;
+	DmSegment_release(transition);
+	return rv;
+}
+
+DmResult DmPerformance_setRandomSeed(DmPerformance* slf, uint64_t seed) {
+	if (slf == NULL) {
+		return DmResult_INVALID_ARGUMENT;
 	}
 
-	DmSegment_release(transition);
+	if (mtx_lock(&slf->lock) != thrd_success) {
+		return DmResult_MUTEX_ERROR;
+	}
+
+	DmRandom_init(&slf->rng, seed);
+
+	(void) mtx_unlock(&slf->lock);
 	return DmResult_SUCCESS;
 }
 
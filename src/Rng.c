@@ -28,3 +28,48 @@ static uint32_t DmInt_defaultRng(void* ctx) {
 	(void) ctx;
 	return rand();
 }
+
+static uint64_t DmInt_splitMix64(uint64_t* state) {
+	uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+static uint32_t DmInt_rotl(uint32_t x, int k) {
+	return (x << k) | (x >> (32 - k));
+}
+
+// The state is expanded from the 64-bit seed using SplitMix64 as recommended by the xoshiro authors, which
+// guarantees that the state is never all zeroes.
+// See: https://prng.di.unimi.it/
+void DmRandom_init(DmRandom* slf, uint64_t seed) {
+	if (slf == NULL) {
+		return;
+	}
+
+	uint64_t a = DmInt_splitMix64(&seed);
+	uint64_t b = DmInt_splitMix64(&seed);
+
+	slf->state[0] = (uint32_t) a;
+	slf->state[1] = (uint32_t) (a >> 32);
+	slf->state[2] = (uint32_t) b;
+	slf->state[3] = (uint32_t) (b >> 32);
+}
+
+// xoshiro128**, see https://prng.di.unimi.it/xoshiro128starstar.c
+uint32_t DmRandom_next(DmRandom* slf) {
+	uint32_t* s = slf->state;
+	uint32_t const result = DmInt_rotl(s[1] * 5, 7) * 9;
+	uint32_t const t = s[1] << 9;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+
+	s[2] ^= t;
+	s[3] = DmInt_rotl(s[3], 11);
+
+	return result;
+}
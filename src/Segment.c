@@ -15,6 +15,7 @@ DmResult DmSegment_create(DmSegment** slf) {
 	new->reference_count = 1;
 
 	DmMessageList_init(&new->messages);
+	(void) DmArena_init(&new->arena, 0);
 
 	return DmResult_SUCCESS;
 }
@@ -41,7 +42,8 @@ void DmSegment_release(DmSegment* slf) {
 	}
 
 	DmMessageList_free(&slf->messages);
-	Dm_free(slf->backing_memory);
+	DmArena_free(&slf->arena);
+	Dm_releaseBuffer(slf->backing_memory, slf->backing_length, slf->backing_release, slf->backing_context);
 	Dm_free(slf);
 }
 
@@ -45,7 +45,8 @@ void DmStyle_release(DmStyle* slf) {
 	DmPatternList_free(&slf->patterns);
 	DmBandList_free(&slf->bands);
 	DmPartList_free(&slf->parts);
-	Dm_free(slf->backing_memory);
+	DmArena_free(&slf->arena);
+	Dm_releaseBuffer(slf->backing_memory, slf->backing_length, slf->backing_release, slf->backing_context);
 	Dm_free(slf);
 }
 
@@ -102,7 +103,7 @@ static uint32_t Dm_toEmbellishmentFlagset(DmCommandType cmd) {
 }
 
 // See: https://documentation.help/DirectMusic/howmusicvariesduringplayback.htm
-DmPattern* DmStyle_getRandomPattern(DmStyle* slf, uint32_t groove, DmCommandType cmd) {
+DmPattern* DmStyle_getRandomPattern(DmStyle* slf, DmRandom* rng, uint32_t groove, DmCommandType cmd) {
 	uint32_t embellishment = Dm_toEmbellishmentFlagset(cmd);
 
 	// Select a random pattern according to the current groove level.
@@ -110,7 +111,7 @@ DmPattern* DmStyle_getRandomPattern(DmStyle* slf, uint32_t groove, DmCommandType
 	//                   have some way of defining how to select the pattern if more than 1 choice is available
 	//                   but I couldn't find it.
 
-	int64_t index = Dm_rand() % (uint32_t) slf->patterns.length;
+	int64_t index = DmRandom_next(rng) % (uint32_t) slf->patterns.length;
 	bool found_one = false;
 	do {
 		for (size_t i = 0; i < slf->patterns.length; ++i) {
@@ -152,15 +153,6 @@ void DmPart_init(DmPart* slf) {
 	memset(slf, 0, sizeof *slf);
 }
 
-void DmPart_free(DmPart* slf) {
-	if (slf == NULL) {
-		return;
-	}
-
-	Dm_free(slf->notes);
-	Dm_free(slf->curves);
-}
-
 uint32_t DmPart_getValidVariationCount(DmPart* slf) {
 	if (slf == NULL) {
 		return 0;
@@ -203,7 +195,6 @@ void DmPattern_free(DmPattern* slf) {
 	}
 
 	DmPartReferenceList_free(&slf->parts);
-	Dm_free(slf->rhythm);
 	slf->rhythm = NULL;
 	slf->rhythm_len = 0;
 }
@@ -25,6 +25,7 @@ void DmSynth_init(DmSynth* slf, uint32_t sample_rate) {
 	slf->volume = 1;
 
 	DmSynthFontArray_init(&slf->fonts);
+	DmSynthChannelArray_init(&slf->channels);
 }
 
 void DmSynth_free(DmSynth* slf) {
@@ -32,30 +33,127 @@ void DmSynth_free(DmSynth* slf) {
 		return;
 	}
 
-	Dm_free(slf->channels);
+	DmSynthChannelArray_free(&slf->channels);
+	Dm_free(slf->channel_map);
 	DmSynthFontArray_free(&slf->fonts);
 }
 
+static void DmSynthChannel_setVolume(DmSynthChannel* slf, float vol) {
+	tsf_channel_set_volume(slf->font->syn, slf->channel, vol);
+	slf->volume = vol;
+}
+
+static void DmSynthChannel_setPan(DmSynthChannel* slf, float pan) {
+	tsf_channel_set_pan(slf->font->syn, slf->channel, pan);
+	slf->pan = pan;
+}
+
 void DmSynth_reset(DmSynth* slf) {
 	if (slf == NULL) {
 		return;
 	}
 
-	for (uint32_t i = 0; i < slf->channels_len; ++i) {
-		DmSynthChannel* chan = &slf->channels[i];
+	for (size_t i = 0; i < slf->channels.length; ++i) {
+		DmSynthChannel* chan = &slf->channels.data[i];
 		if (chan->font == NULL) {
 			continue;
 		}
 
-		tsf_channel_set_volume(chan->font->syn, chan->channel, chan->reset_volume);
-		tsf_channel_set_pan(chan->font->syn, chan->channel, chan->reset_pan);
+		DmSynthChannel_setVolume(chan, chan->reset_volume);
+		DmSynthChannel_setPan(chan, chan->reset_pan);
 		tsf_channel_set_pitchwheel(chan->font->syn, chan->channel, chan->reset_pitch);
 	}
 }
 
+// Performance channels are usually small and consecutive, but they are mixed anyway since some bands use channels
+// which are multiples of 16 apart.
+static size_t DmSynth_hashChannel(uint32_t channel) {
+	channel ^= channel >> 16;
+	channel *= 0x45D9F3BU;
+	channel ^= channel >> 16;
+	return channel;
+}
+
+static DmSynthChannel* DmSynth_getChannel(DmSynth* slf, uint32_t channel) {
+	if (slf->channel_map_len == 0) {
+		return NULL;
+	}
+
+	size_t mask = slf->channel_map_len - 1;
+	for (size_t i = DmSynth_hashChannel(channel) & mask;; i = (i + 1) & mask) {
+		uint32_t index = slf->channel_map[i];
+		if (index == 0) {
+			return NULL;
+		}
+
+		DmSynthChannel* chan = &slf->channels.data[index - 1];
+		if (chan->pchannel == channel) {
+			return chan;
+		}
+	}
+}
+
+static void DmSynth_mapChannel(DmSynth* slf, size_t index) {
+	size_t mask = slf->channel_map_len - 1;
+	size_t i = DmSynth_hashChannel(slf->channels.data[index].pchannel) & mask;
+	while (slf->channel_map[i] != 0) {
+		i = (i + 1) & mask;
+	}
+
+	slf->channel_map[i] = (uint32_t) index + 1;
+}
+
+static DmResult DmSynth_addChannel(DmSynth* slf, uint32_t channel, DmSynthChannel** out) {
+	// Keep the load factor at or below 0.5
+	if ((slf->channels.length + 1) * 2 > slf->channel_map_len) {
+		size_t map_len = max_usize(slf->channel_map_len * 2, 16);
+		uint32_t* map = Dm_alloc(map_len * sizeof *map);
+		if (map == NULL) {
+			return DmResult_MEMORY_EXHAUSTED;
+		}
+
+		Dm_free(slf->channel_map);
+		slf->channel_map = map;
+		slf->channel_map_len = map_len;
+
+		for (size_t i = 0; i < slf->channels.length; ++i) {
+			DmSynth_mapChannel(slf, i);
+		}
+	}
+
+	DmSynthChannel chan;
+	memset(&chan, 0, sizeof chan);
+	chan.pchannel = channel;
+	chan.channel = (int32_t) slf->channels.length;
+
+	DmResult rv = DmSynthChannelArray_add(&slf->channels, chan);
+	if (rv != DmResult_SUCCESS) {
+		return rv;
+	}
+
+	DmSynth_mapChannel(slf, slf->channels.length - 1);
+	*out = &slf->channels.data[slf->channels.length - 1];
+	return DmResult_SUCCESS;
+}
+
+static void DmSynth_clearChannels(DmSynth* slf) {
+	DmSynthChannelArray_free(&slf->channels);
+	Dm_free(slf->channel_map);
+	slf->channel_map = NULL;
+	slf->channel_map_len = 0;
+}
+
+// The collection remembers where its font was last found, so the lookup only has to search the fonts if multiple
+// synthesizers use the collection at the same time.
 static DmSynthFont* DmSynth_getFont(DmSynth* slf, DmInstrument* ins) {
+	size_t hint = atomic_load_explicit(&ins->dls->synth_font, memory_order_relaxed);
+	if (hint < slf->fonts.length && slf->fonts.data[hint].dls == ins->dls) {
+		return &slf->fonts.data[hint];
+	}
+
 	for (size_t i = 0; i < slf->fonts.length; ++i) {
 		if (slf->fonts.data[i].dls == ins->dls) {
+			atomic_store_explicit(&ins->dls->synth_font, i, memory_order_relaxed);
 			return &slf->fonts.data[i];
 		}
 	}
@@ -75,33 +173,37 @@ static DmResult DmSynth_updateFonts(DmSynth* slf, DmBand* band) {
 		// The instrument font does not yet exist. Create it anew!
 		if (fnt == NULL) {
 			DmSynthFont new_fnt;
-			new_fnt.dls = ins->dls;
 
 			DmResult rv = DmResult_SUCCESS;
-			rv = DmSynth_createTsfForDls(ins->dls, &new_fnt.syn);
+			rv = DmDls_getFont(ins->dls, &new_fnt.syn);
 			if (rv != DmResult_SUCCESS) {
 				continue;
 			}
 
+			// The font keeps its DLS collection alive so that the loader does not evict it while it is in use.
+			new_fnt.dls = DmDls_retain(ins->dls);
+
 			tsf_set_output(new_fnt.syn, TSF_STEREO_INTERLEAVED, (int) slf->rate, 0);
 			tsf_set_volume(new_fnt.syn, slf->volume);
 
-			if (slf->channels_len > 0) {
+			if (slf->channels.length > 0) {
 				// If we add an element to the font array, we need to adjust the cached fonts for each channel,
 				// since a resize might re-allocate the array and thus break existing references to the old array.
 				DmSynthFont* old = slf->fonts.data;
 				rv = DmSynthFontArray_add(&slf->fonts, new_fnt);
 
 				if (rv != DmResult_SUCCESS) {
+					DmDls_closeFont(new_fnt.dls, new_fnt.syn);
+					DmDls_release(new_fnt.dls);
 					return rv;
 				}
 
 				// This is the offset between the old and new arrays; we need to add it to the old references
 				// to bring them back into scope.
 				size_t offset = slf->fonts.data - old;
-				for (size_t r = 0; r < slf->channels_len; ++r) {
-					if (slf->channels[r].font != NULL) {
-						slf->channels[r].font += offset;
+				for (size_t r = 0; r < slf->channels.length; ++r) {
+					if (slf->channels.data[r].font != NULL) {
+						slf->channels.data[r].font += offset;
 					}
 				}
 			} else {
@@ -109,39 +211,52 @@ static DmResult DmSynth_updateFonts(DmSynth* slf, DmBand* band) {
 			}
 
 			if (rv != DmResult_SUCCESS) {
+				DmDls_closeFont(new_fnt.dls, new_fnt.syn);
+				DmDls_release(new_fnt.dls);
 				return rv;
 			}
+
+			atomic_store_explicit(&ins->dls->synth_font, slf->fonts.length - 1, memory_order_relaxed);
 		}
 	}
 
 	return DmResult_SUCCESS;
 }
 
-// See https://documentation.help/DirectMusic/usingbands.htm
-static DmResult DmSynth_assignInstrumentChannels(DmSynth* slf, DmBand* band) {
-	// Calculate the number of required performance channels
-	size_t channel_count = 0;
-	for (size_t i = 0; i < band->instruments_len; ++i) {
-		channel_count = max_usize(band->instruments[i].channel, channel_count);
-	}
-	channel_count += 1;
+// Drop fonts which are not assigned to any channel and have no voices left playing, so that their
+// DLS collections can be released.
+static void DmSynth_pruneFonts(DmSynth* slf) {
+	size_t kept = 0;
+	for (size_t i = 0; i < slf->fonts.length; ++i) {
+		DmSynthFont* fnt = &slf->fonts.data[i];
 
-	// Increase the size of the channel array (if required)
-	if (channel_count > slf->channels_len) {
-		DmSynthChannel* new_channels = Dm_alloc(sizeof(DmSynthChannel) * channel_count);
-		if (new_channels == NULL) {
-			return DmResult_MEMORY_EXHAUSTED;
+		bool used = tsf_active_voice_count(fnt->syn) > 0;
+		for (size_t c = 0; c < slf->channels.length && !used; ++c) {
+			used = slf->channels.data[c].font == fnt;
 		}
 
-		if (slf->channels != NULL) {
-			memcpy(new_channels, slf->channels, sizeof(DmSynthChannel) * slf->channels_len);
-			Dm_free(slf->channels);
+		if (!used) {
+			DmDls_closeFont(fnt->dls, fnt->syn);
+			DmDls_release(fnt->dls);
+			continue;
 		}
 
-		slf->channels = new_channels;
-		slf->channels_len = channel_count;
+		// Move the font down to close the gap and update the channels referencing it.
+		for (size_t c = 0; c < slf->channels.length; ++c) {
+			if (slf->channels.data[c].font == fnt) {
+				slf->channels.data[c].font = &slf->fonts.data[kept];
+			}
+		}
+
+		atomic_store_explicit(&fnt->dls->synth_font, kept, memory_order_relaxed);
+		slf->fonts.data[kept++] = *fnt;
 	}
 
+	slf->fonts.length = kept;
+}
+
+// See https://documentation.help/DirectMusic/usingbands.htm
+static DmResult DmSynth_assignInstrumentChannels(DmSynth* slf, DmBand* band) {
 	// Assign the instrument to each channel.
 	// NOTE: We do not clear existing channels since that is what the band change spec requires.
 	//       Essentially, existing channels stay as-is and only the channels from the new band
@@ -153,7 +268,13 @@ static DmResult DmSynth_assignInstrumentChannels(DmSynth* slf, DmBand* band) {
 			continue;
 		}
 
-		DmSynthChannel* chan = &slf->channels[ins->channel];
+		DmSynthChannel* chan = DmSynth_getChannel(slf, ins->channel);
+		if (chan == NULL) {
+			DmResult rv = DmSynth_addChannel(slf, ins->channel, &chan);
+			if (rv != DmResult_SUCCESS) {
+				return rv;
+			}
+		}
 
 		// If this is the first time we're initializing the channel,
 		// set the reset fields to the default values.
@@ -165,29 +286,52 @@ static DmResult DmSynth_assignInstrumentChannels(DmSynth* slf, DmBand* band) {
 		}
 
 		DmSynthFont* fnt = DmSynth_getFont(slf, ins);
+
+		// Segments send the same band again every time they loop, in which case the preset does not need to be
+		// assigned again.
+		bool unchanged = fnt != NULL && chan->font == fnt && chan->patch == ins->patch;
+
 		chan->font = fnt;
-		chan->channel = (int) ins->channel;
+		chan->patch = ins->patch;
 
 		if (fnt == NULL) {
 			continue;
 		}
 
-		uint32_t bank = (ins->patch & 0xFF00U) >> 8;
-		uint32_t patch = ins->patch & 0xFFU;
+		if (!unchanged) {
+			uint32_t bank = (ins->patch & 0xFF00U) >> 8;
+			uint32_t patch = ins->patch & 0xFFU;
 
-		tsf_set_volume(fnt->syn, slf->volume);
-		tsf_channel_set_bank_preset(fnt->syn, (int) ins->channel, (int) bank, (int) patch);
+			tsf_set_volume(fnt->syn, slf->volume);
+			tsf_channel_set_bank_preset(fnt->syn, chan->channel, (int) bank, (int) patch);
+			chan->volume = -1;
+			chan->pan = -1;
+
+			// When streaming, the preset's waves are only decoded once it is assigned to a channel. If that fails,
+			// the channel is left without a font, so that the missing waves are never played.
+			DmResult rv = DmDls_decodePreset(ins->dls, fnt->syn, tsf_channel_get_preset_index(fnt->syn, chan->channel));
+			if (rv != DmResult_SUCCESS) {
+				Dm_report(DmLogLevel_ERROR, "DmSynth: Failed to decode the waves of instrument %u", ins->patch);
+				chan->font = NULL;
+				continue;
+			}
+		}
 
-		// Update the instrument's properties
+		// Update the instrument's properties. Control changes might have altered them since the band was last sent,
+		// so they are compared against the values last sent to the channel.
 		if (ins->options & DmInstrument_VALID_PAN) {
 			float pan = (float) ins->pan / (float) DmInt_MIDI_MAX;
-			tsf_channel_set_pan(fnt->syn, (int) ins->channel, pan);
+			if (chan->pan != pan) {
+				DmSynthChannel_setPan(chan, pan);
+			}
 			chan->reset_pan = pan;
 		}
 
 		if (ins->options & DmInstrument_VALID_VOLUME) {
 			float vol = (float) ins->volume / (float) DmInt_MIDI_MAX;
-			tsf_channel_set_volume(fnt->syn, (int) ins->channel, vol);
+			if (chan->volume != vol) {
+				DmSynthChannel_setVolume(chan, vol);
+			}
 			chan->reset_volume = vol;
 		}
 
@@ -207,9 +351,7 @@ void DmSynth_sendBandUpdate(DmSynth* slf, DmBand* band) {
 
 	DmResult rv = DmSynth_updateFonts(slf, band);
 	if (rv != DmResult_SUCCESS) {
-		Dm_free(slf->channels);
-		slf->channels = NULL;
-		slf->channels_len = 0;
+		DmSynth_clearChannels(slf);
 		return;
 	}
 
@@ -217,34 +359,36 @@ void DmSynth_sendBandUpdate(DmSynth* slf, DmBand* band) {
 	if (rv != DmResult_SUCCESS) {
 		return;
 	}
+
+	DmSynth_pruneFonts(slf);
 }
 
 void DmSynth_sendControl(DmSynth* slf, uint32_t channel, uint8_t control, float value) {
-	if (slf == NULL || channel >= slf->channels_len) {
+	if (slf == NULL) {
 		return;
 	}
 
-	DmSynthChannel* chan = &slf->channels[channel];
-	if (chan->font == NULL) {
+	DmSynthChannel* chan = DmSynth_getChannel(slf, channel);
+	if (chan == NULL || chan->font == NULL) {
 		return;
 	}
 
 	if (control == DmInt_MIDI_CC_VOLUME || control == DmInt_MIDI_CC_EXPRESSION) {
-		tsf_channel_set_volume(chan->font->syn, chan->channel, value);
+		DmSynthChannel_setVolume(chan, value);
 	} else if (control == DmInt_MIDI_CC_PAN) {
-		tsf_channel_set_pan(chan->font->syn, chan->channel, value);
+		DmSynthChannel_setPan(chan, value);
 	} else {
 		Dm_report(DmLogLevel_WARN, "DmSynth: Control change %d is unknown.", control);
 	}
 }
 
 void DmSynth_sendControlReset(DmSynth* slf, uint32_t channel, uint8_t control, float reset) {
-	if (slf == NULL || channel >= slf->channels_len) {
+	if (slf == NULL) {
 		return;
 	}
 
-	DmSynthChannel* chan = &slf->channels[channel];
-	if (chan->font == NULL) {
+	DmSynthChannel* chan = DmSynth_getChannel(slf, channel);
+	if (chan == NULL || chan->font == NULL) {
 		return;
 	}
 
@@ -258,12 +402,12 @@ void DmSynth_sendControlReset(DmSynth* slf, uint32_t channel, uint8_t control, f
 }
 
 void DmSynth_sendPitchBend(DmSynth* slf, uint32_t channel, int bend) {
-	if (slf == NULL || channel >= slf->channels_len) {
+	if (slf == NULL) {
 		return;
 	}
 
-	DmSynthChannel* chan = &slf->channels[channel];
-	if (chan->font == NULL) {
+	DmSynthChannel* chan = DmSynth_getChannel(slf, channel);
+	if (chan == NULL || chan->font == NULL) {
 		return;
 	}
 
@@ -271,12 +415,12 @@ void DmSynth_sendPitchBend(DmSynth* slf, uint32_t channel, int bend) {
 }
 
 void DmSynth_sendPitchBendReset(DmSynth* slf, uint32_t channel, int reset) {
-	if (slf == NULL || channel >= slf->channels_len) {
+	if (slf == NULL) {
 		return;
 	}
 
-	DmSynthChannel* chan = &slf->channels[channel];
-	if (chan->font == NULL) {
+	DmSynthChannel* chan = DmSynth_getChannel(slf, channel);
+	if (chan == NULL || chan->font == NULL) {
 		return;
 	}
 
@@ -284,12 +428,12 @@ void DmSynth_sendPitchBendReset(DmSynth* slf, uint32_t channel, int reset) {
 }
 
 void DmSynth_sendNoteOn(DmSynth* slf, uint32_t channel, uint8_t note, uint8_t velocity) {
-	if (slf == NULL || channel >= slf->channels_len) {
+	if (slf == NULL) {
 		return;
 	}
 
-	DmSynthChannel* chan = &slf->channels[channel];
-	if (chan->font == NULL) {
+	DmSynthChannel* chan = DmSynth_getChannel(slf, channel);
+	if (chan == NULL || chan->font == NULL) {
 		return;
 	}
 
@@ -301,12 +445,12 @@ void DmSynth_sendNoteOn(DmSynth* slf, uint32_t channel, uint8_t note, uint8_t ve
 }
 
 void DmSynth_sendNoteOff(DmSynth* slf, uint32_t channel, uint8_t note) {
-	if (slf == NULL || channel >= slf->channels_len) {
+	if (slf == NULL) {
 		return;
 	}
 
-	DmSynthChannel* chan = &slf->channels[channel];
-	if (chan->font == NULL) {
+	DmSynthChannel* chan = DmSynth_getChannel(slf, channel);
+	if (chan == NULL || chan->font == NULL) {
 		return;
 	}
 
@@ -314,12 +458,12 @@ void DmSynth_sendNoteOff(DmSynth* slf, uint32_t channel, uint8_t note) {
 }
 
 void DmSynth_sendNoteOffAll(DmSynth* slf, uint32_t channel) {
-	if (slf == NULL || channel >= slf->channels_len) {
+	if (slf == NULL) {
 		return;
 	}
 
-	DmSynthChannel* chan = &slf->channels[channel];
-	if (chan->font == NULL) {
+	DmSynthChannel* chan = DmSynth_getChannel(slf, channel);
+	if (chan == NULL || chan->font == NULL) {
 		return;
 	}
 
@@ -331,8 +475,11 @@ void DmSynth_sendNoteOffEverything(DmSynth* slf) {
 		return;
 	}
 
-	for (uint32_t i = 0; i < slf->channels_len; ++i) {
-		DmSynth_sendNoteOffAll(slf, i);
+	for (size_t i = 0; i < slf->channels.length; ++i) {
+		DmSynthChannel* chan = &slf->channels.data[i];
+		if (chan->font != NULL) {
+			tsf_channel_note_off_all(chan->font->syn, chan->channel);
+		}
 	}
 }
 
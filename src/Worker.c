@@ -0,0 +1,225 @@
+// Copyright © 2024. GothicKit Contributors
+// SPDX-License-Identifier: MIT-Modern-Variant
+#include "_Internal.h"
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <unistd.h>
+#endif
+
+enum {
+	DmInt_PARALLEL_MAX_THREADS = 8,
+};
+
+typedef struct DmParallelRange {
+	DmParallelFunc* run;
+	void* context;
+	size_t begin;
+	size_t end;
+} DmParallelRange;
+
+static int DmWorkerPool_run(void* ctx) {
+	DmWorkerPool* slf = ctx;
+
+	if (mtx_lock(&slf->lock) != thrd_success) {
+		return -1;
+	}
+
+	for (;;) {
+		while (slf->head == NULL && !slf->stop) {
+			(void) cnd_wait(&slf->wake, &slf->lock);
+		}
+
+		// Only exit once all pending tasks have been run.
+		if (slf->head == NULL) {
+			break;
+		}
+
+		DmWorkerTask* task = slf->head;
+		slf->head = task->next;
+		if (slf->head == NULL) {
+			slf->tail = NULL;
+		}
+
+		(void) mtx_unlock(&slf->lock);
+
+		task->run(task->context);
+		Dm_free(task);
+
+		if (mtx_lock(&slf->lock) != thrd_success) {
+			return -1;
+		}
+	}
+
+	bool orphaned = slf->orphaned;
+	(void) mtx_unlock(&slf->lock);
+
+	if (orphaned) {
+		(void) thrd_detach(thrd_current());
+		cnd_destroy(&slf->wake);
+		mtx_destroy(&slf->lock);
+		Dm_free(slf);
+	}
+
+	return 0;
+}
+
+DmResult DmWorkerPool_create(DmWorkerPool** slf, size_t threads) {
+	if (slf == NULL || threads == 0) {
+		return DmResult_INVALID_ARGUMENT;
+	}
+
+	DmWorkerPool* new = *slf = Dm_alloc(sizeof *new + threads * sizeof *new->threads);
+	if (new == NULL) {
+		return DmResult_MEMORY_EXHAUSTED;
+	}
+
+	if (mtx_init(&new->lock, mtx_plain) != thrd_success) {
+		Dm_free(new);
+		return DmResult_MUTEX_ERROR;
+	}
+
+	if (cnd_init(&new->wake) != thrd_success) {
+		mtx_destroy(&new->lock);
+		Dm_free(new);
+		return DmResult_MUTEX_ERROR;
+	}
+
+	for (; new->thread_count < threads; ++new->thread_count) {
+		if (thrd_create(&new->threads[new->thread_count], DmWorkerPool_run, new) != thrd_success) {
+			break;
+		}
+	}
+
+	if (new->thread_count == 0) {
+		DmWorkerPool_destroy(new);
+		*slf = NULL;
+		return DmResult_MEMORY_EXHAUSTED;
+	}
+
+	return DmResult_SUCCESS;
+}
+
+void DmWorkerPool_destroy(DmWorkerPool* slf) {
+	if (slf == NULL) {
+		return;
+	}
+
+	if (mtx_lock(&slf->lock) == thrd_success) {
+		slf->stop = true;
+		(void) cnd_broadcast(&slf->wake);
+		(void) mtx_unlock(&slf->lock);
+	}
+
+	// A worker can't join itself. If the pool is destroyed from within one of its tasks, the other workers are joined
+	// and the calling worker frees the pool once it has run the remaining tasks.
+	bool on_worker = false;
+	for (size_t i = 0; i < slf->thread_count; ++i) {
+		if (thrd_equal(slf->threads[i], thrd_current())) {
+			on_worker = true;
+			continue;
+		}
+
+		(void) thrd_join(slf->threads[i], NULL);
+	}
+
+	if (on_worker) {
+		if (mtx_lock(&slf->lock) == thrd_success) {
+			slf->orphaned = true;
+			(void) mtx_unlock(&slf->lock);
+		}
+		return;
+	}
+
+	cnd_destroy(&slf->wake);
+	mtx_destroy(&slf->lock);
+	Dm_free(slf);
+}
+
+DmResult DmWorkerPool_submit(DmWorkerPool* slf, DmWorkerFunc* run, void* ctx) {
+	if (slf == NULL || run == NULL) {
+		return DmResult_INVALID_ARGUMENT;
+	}
+
+	DmWorkerTask* task = Dm_alloc(sizeof *task);
+	if (task == NULL) {
+		return DmResult_MEMORY_EXHAUSTED;
+	}
+
+	task->run = run;
+	task->context = ctx;
+	task->next = NULL;
+
+	if (mtx_lock(&slf->lock) != thrd_success) {
+		Dm_free(task);
+		return DmResult_MUTEX_ERROR;
+	}
+
+	if (slf->tail == NULL) {
+		slf->head = task;
+	} else {
+		slf->tail->next = task;
+	}
+	slf->tail = task;
+
+	(void) cnd_signal(&slf->wake);
+	(void) mtx_unlock(&slf->lock);
+	return DmResult_SUCCESS;
+}
+
+static size_t Dm_getProcessorCount(void) {
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+#else
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (size_t) count : 1;
+#endif
+}
+
+static void DmParallelRange_run(void* ctx) {
+	DmParallelRange* slf = ctx;
+	slf->run(slf->context, slf->begin, slf->end);
+}
+
+// The ranges are run on a pool of their own, since the caller might itself be running on a loader worker. Waiting for
+// tasks queued behind it on the same pool would deadlock.
+void Dm_runParallel(size_t count, size_t grain, DmParallelFunc* run, void* ctx) {
+	if (count == 0) {
+		return;
+	}
+
+	size_t range_count = (count + grain - 1) / grain;
+	size_t thread_count = min_usize(min_usize(Dm_getProcessorCount(), DmInt_PARALLEL_MAX_THREADS), range_count);
+	if (thread_count <= 1) {
+		run(ctx, 0, count);
+		return;
+	}
+
+	DmParallelRange* ranges = Dm_alloc(range_count * sizeof *ranges);
+	DmWorkerPool* pool = NULL;
+	if (ranges == NULL || DmWorkerPool_create(&pool, thread_count) != DmResult_SUCCESS) {
+		Dm_free(ranges);
+		run(ctx, 0, count);
+		return;
+	}
+
+	for (size_t i = 0; i < range_count; ++i) {
+		DmParallelRange* range = &ranges[i];
+		range->run = run;
+		range->context = ctx;
+		range->begin = i * grain;
+		range->end = min_usize(range->begin + grain, count);
+
+		if (DmWorkerPool_submit(pool, DmParallelRange_run, range) != DmResult_SUCCESS) {
+			DmParallelRange_run(range);
+		}
+	}
+
+	// Destroying the pool waits for all queued ranges to finish.
+	DmWorkerPool_destroy(pool);
+	Dm_free(ranges);
+}
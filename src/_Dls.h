@@ -2,6 +2,8 @@
 // SPDX-License-Identifier: MIT-Modern-Variant
 #pragma once
 #include "_Riff.h"
+#include "thread/Thread.h"
+#include "util/Arena.h"
 
 typedef enum DmDlsArticulatorSource {
 	DmDlsArticulatorSource_NONE = 0,
@@ -183,6 +185,11 @@ typedef struct DmDlsWave {
 typedef struct DmDls {
 	_Atomic size_t reference_count;
 	void* backing_memory;
+	size_t backing_length;
+
+	/// \brief Releases #backing_memory if set. Otherwise, it is released using #Dm_free.
+	DmLoaderBufferRelease* backing_release;
+	void* backing_context;
 
 	DmGuid guid;
 	DmVersion version;
@@ -191,11 +198,58 @@ typedef struct DmDls {
 	uint32_t instrument_count;
 	DmDlsInstrument* instruments;
 
+	/// \brief Owns the regions, articulators and connections of all instruments.
+	DmArena arena;
+
 	uint32_t pool_table_size;
 	uint32_t* pool_table;
 
 	uint32_t wave_table_size;
 	DmDlsWave* wave_table;
+
+	/// \brief The synthesizer font built from the collection. Created on first use and shared by all synthesizers
+	///        using the collection through `tsf_copy`.
+	struct tsf* font;
+
+	/// \brief The path of the precompiled font cache file of the collection or `NULL` if caching is disabled.
+	char* font_cache_path;
+
+	/// \brief The memory mapping #font was loaded from, if it was loaded from the cache. The font's samples point
+	///        into this mapping.
+	void* font_mapping;
+	size_t font_mapping_length;
+
+	/// \brief Whether waves are decoded into #font on demand. See #DmLoader_STREAM.
+	bool stream;
+
+	/// \brief The memory reserved for the samples of #font if it was created for streaming.
+	float* font_samples;
+	size_t font_samples_length;
+
+	/// \brief When streaming, the offset of each wave's samples in #font_samples. Has one additional element
+	///        containing the total number of samples. `NULL` if all waves are decoded.
+	uint32_t* wave_offsets;
+
+	/// \brief When streaming, whether each wave has already been decoded.
+	bool* wave_decoded;
+
+	/// \brief The index of a copy of #font in the #DmSynth::fonts of the synthesizer which last looked it up. Only a
+	///        hint, since multiple synthesizers might use the collection.
+	_Atomic size_t synth_font;
+
+	/// \brief The number of bytes of samples in #font. When streaming, only decoded waves are counted.
+	size_t font_size;
+
+	/// \brief The counter of the loader caching the collection, to which #font_size is added, or `NULL`. Guarded by
+	///        #font_lock.
+	_Atomic size_t* font_memory;
+
+	/// \brief The time spent building or loading #font in nanoseconds.
+	_Atomic uint64_t font_time;
+
+	/// \brief Guards #font. TinySoundFont does not synchronize the reference count shared between copies of a
+	///        font, so copies must be created and closed with this lock held.
+	mtx_t font_lock;
 } DmDls;
 
 DMINT DmResult DmDls_create(DmDls** slf);
@@ -204,12 +258,7 @@ DMINT size_t DmDls_release(DmDls*);
 DMINT DmResult DmDls_parse(DmDls* slf, void* buf, size_t len);
 
 DMINT void DmDlsInstrument_init(DmDlsInstrument* slf);
-DMINT void DmDlsInstrument_free(DmDlsInstrument* slf);
-
 DMINT void DmDlsRegion_init(DmDlsRegion* slf);
-DMINT void DmDlsRegion_free(DmDlsRegion* slf);
-
 DMINT void DmDlsArticulator_init(DmDlsArticulator* slf);
-DMINT void DmDlsArticulator_free(DmDlsArticulator* slf);
 
 DMINT size_t DmDls_decodeSamples(DmDlsWave const* slf, float* out, size_t len);
@@ -48,26 +48,205 @@ typedef struct DmTimeSignature {
 	uint16_t grids_per_beat;
 } DmTimeSignature;
 
+/// \brief State of a xoshiro128** pseudo-random number generator.
+///
+/// Each performance owns one of these, so that concurrently rendering performances never share generator state
+/// and a performance seeded with #DmPerformance_setRandomSeed always produces the same sequence of choices.
+typedef struct DmRandom {
+	uint32_t state[4];
+} DmRandom;
+
+typedef void DmResolverDestroy(void* ctx);
+
+typedef struct DmResolverCounters {
+	_Atomic size_t hits;
+	_Atomic size_t misses;
+} DmResolverCounters;
+
+/// \brief A resolver added to a loader. Exactly one of #resolve and #resolve_buffer is set.
 typedef struct DmResolver {
 	DmLoaderResolverCallback* resolve;
+	DmLoaderBufferResolverCallback* resolve_buffer;
 	void* context;
+
+	/// \brief Releases #context when the loader is released. Only set for resolvers owned by the loader.
+	DmResolverDestroy* destroy;
+
+	/// \brief The number of files the resolver found and did not find. Shared by all copies of the resolver.
+	DmResolverCounters* counters;
 } DmResolver;
 
+/// \brief A directory indexed by case-insensitive file name. Files are served as read-only memory mappings.
+typedef struct DmDirectory DmDirectory;
+typedef void DmDirectoryVisitor(void* ctx, char const* name, char const* path);
+
+/// \brief A reference-counted, memory-mapped pack file. See Pack.c for the file format.
+typedef struct DmPack DmPack;
+
 struct DmStyle;
 
-DmArray_DEFINE(DmResolverList, DmResolver);
-DmArray_DEFINE(DmDlsCache, DmDls*);
-DmArray_DEFINE(DmStyleCache, struct DmStyle*);
+/// \brief An immutable, reference-counted list of resolvers.
+///
+/// Adding a resolver to a loader replaces its list with a new copy, so that loading threads can take a reference to
+/// the current list and call the resolvers without holding the loader's lock.
+typedef struct DmResolverList {
+	_Atomic size_t reference_count;
+	size_t length;
+	DmResolver data[];
+} DmResolverList;
+
+typedef enum DmCacheState {
+	/// \brief The object is being loaded by another thread.
+	DmCacheState_LOADING = 0,
+
+	/// \brief The object was loaded successfully.
+	DmCacheState_READY = 1,
+
+	/// \brief Loading the object failed. The entry has been removed from the cache.
+	DmCacheState_FAILED = 2,
+} DmCacheState;
+
+/// \brief An object in a #DmCache, indexed by both its GUID and its file name.
+typedef struct DmCacheEntry {
+	struct DmCacheEntry* next_guid;
+	struct DmCacheEntry* next_file;
+
+	/// \brief The neighbours of the entry in its cache's list of ready entries, ordered by their last use.
+	struct DmCacheEntry* prev_used;
+	struct DmCacheEntry* next_used;
+
+	DmGuid guid;
+	uint64_t guid_hash;
+	char* file;
+	uint64_t file_hash;
+
+	DmCacheState state;
+	DmResult result;
+
+	/// \brief The number of threads waiting for the entry to finish loading.
+	size_t waiters;
+	void* object;
+
+	/// \brief The number of bytes of memory accounted to the entry.
+	size_t size;
+
+	/// \brief The value of the owner's clock when the entry was last accessed. Used for LRU eviction.
+	uint64_t last_used;
+} DmCacheEntry;
+
+typedef void* DmCacheRetain(void* obj);
+typedef void DmCacheRelease(void* obj);
+
+/// \brief Determines whether the cache holds the only reference to an object.
+typedef bool DmCacheUnused(void* obj);
+
+/// \brief A hash map of loaded objects which is indexed by GUID and by file name.
+///
+/// Entries are inserted in the #DmCacheState_LOADING state before the object is loaded, so that concurrent
+/// requests for the same object can wait for the first one to finish instead of loading it again.
+typedef struct DmCache {
+	DmCacheEntry** guid_buckets;
+	DmCacheEntry** file_buckets;
+	size_t bucket_count;
+	size_t length;
+
+	/// \brief The sum of the sizes of all entries in the cache.
+	size_t size;
+
+	/// \brief The ends of the list of ready entries, from the least to the most recently used. See #DmCache_touch.
+	DmCacheEntry* least_used;
+	DmCacheEntry* most_used;
+
+	DmCacheRetain* retain;
+	DmCacheRelease* release;
+	DmCacheUnused* unused;
+} DmCache;
+
+typedef void DmWorkerFunc(void* ctx);
+
+typedef struct DmWorkerTask {
+	DmWorkerFunc* run;
+	void* context;
+	struct DmWorkerTask* next;
+} DmWorkerTask;
+
+/// \brief A fixed set of threads running tasks from a shared FIFO queue.
+typedef struct DmWorkerPool {
+	mtx_t lock;
+	cnd_t wake;
+	bool stop;
+
+	/// \brief Set if the pool was destroyed by one of its own workers, which then frees it once it exits.
+	bool orphaned;
+
+	DmWorkerTask* head;
+	DmWorkerTask* tail;
+
+	size_t thread_count;
+	thrd_t threads[];
+} DmWorkerPool;
+
+/// \brief A function processing the elements in `[begin, end)` of a range split up by #Dm_runParallel.
+typedef void DmParallelFunc(void* ctx, size_t begin, size_t end);
+
+/// \brief The statistics of a single file, linked into the hash index of #DmLoader::stats.
+typedef struct DmLoaderStatsRecord {
+	DmLoaderAssetStats stats;
+
+	/// \brief The index of the next record in the same bucket plus one or 0 if this is the last one.
+	size_t next;
+} DmLoaderStatsRecord;
+
+DmArray_DEFINE(DmLoaderStatsRecordList, DmLoaderStatsRecord);
 
 struct DmLoader {
 	_Atomic size_t reference_count;
 	mtx_t lock;
 
+	/// \brief Signalled whenever an object in one of the caches finishes loading.
+	cnd_t loaded;
+
 	bool autodownload;
-	DmResolverList resolvers;
+	bool stream;
+	DmResolverList* resolvers;
+
+	DmCache style_cache;
+	DmCache dls_cache;
+
+	/// \brief Bands embedded in segments, keyed by their GUID and content hash. See #DmBand::hash.
+	DmCache band_cache;
+
+	/// \brief Runs asynchronous loads. Created when it is first needed.
+	DmWorkerPool* workers;
+
+	/// \brief The maximum number of bytes of cached objects to keep or 0 if unlimited.
+	size_t memory_budget;
+
+	/// \brief Incremented on every cache access to order entries by their last use.
+	uint64_t cache_clock;
+
+	/// \brief The number of bytes of samples in the fonts of all cached DLS collections.
+	_Atomic size_t font_memory;
+
+	size_t cache_hits;
+	size_t cache_misses;
+	size_t cache_evictions;
+
+	/// \brief The names of files which none of the resolvers could find.
+	DmCache missing;
+	size_t missing_hits;
+
+	/// \brief The directory precompiled synthesizer fonts are stored in or `NULL` if they are not cached.
+	char* font_cache_directory;
 
-	DmStyleCache style_cache;
-	DmDlsCache dls_cache;
+	/// \brief Statistics about every file loaded, in the order they were first loaded. The font time of DLS
+	///        collections only includes collections which have since been evicted. See #DmDls::font_time.
+	DmLoaderStatsRecordList stats;
+
+	/// \brief Hash buckets indexing #stats by file name. Each holds the index of its first record plus one or 0 if
+	///        it is empty. Grown once there are more records than buckets.
+	size_t* stats_buckets;
+	size_t stats_bucket_count;
 };
 
 typedef enum DmInstrumentFlags {
@@ -171,7 +350,10 @@ typedef struct DmInstrument {
 	DmReference reference;
 
 	/// \brief A pointer to a loaded DLS file containing the instrument samples.
-	DmDls* dls;
+	///
+	/// Bands are shared between segments, so a band might be downloaded while a synthesizer is playing it. This is
+	/// only set once by #DmBand_download and does not change afterward.
+	_Atomic(DmDls*) dls;
 } DmInstrument;
 
 /// \brief A DirectMusic band containing a set of instruments to use for playing MIDI notes.
@@ -191,6 +373,15 @@ typedef struct DmBand {
 	/// \brief The list of instruments available in the band.
 	/// \see #instruments_len
 	DmInstrument* instruments;
+
+	/// \brief Owns the names and file names of all instrument references.
+	DmArena arena;
+
+	/// \brief A hash of the data the band was parsed from. Together with #guid, it identifies identical bands.
+	uint64_t hash;
+
+	/// \brief Serializes downloads, since identical bands are shared between segments.
+	mtx_t download_lock;
 } DmBand;
 
 typedef enum DmPlayModeFlags {
@@ -202,18 +393,27 @@ typedef enum DmPlayModeFlags {
 	DmPlayMode_NONE = 16,
 } DmPlayModeFlags;
 
+// NOTE: Members are ordered by size to keep the note array tightly packed.
 typedef struct DmNote {
 	uint32_t grid_start;
+
+	/// \brief The offset of the note from the start of the pattern in music time. Resolved from #grid_start and
+	///        #time_offset when the style is parsed.
+	uint32_t offset;
+
 	uint32_t variation;
 	uint32_t duration;
+	uint32_t time_range;
+	uint32_t duration_range;
 	int16_t time_offset;
 	uint16_t music_value;
 	uint8_t velocity;
-	uint32_t time_range;
-	uint32_t duration_range;
 	uint8_t velocity_range;
 	uint8_t inversion_id;
-	DmPlayModeFlags play_mode_flags;
+
+	/// \brief The play mode of the note. #DmPlayMode_NONE is replaced by the play mode of the part when the
+	///        style is parsed.
+	uint8_t play_mode_flags;
 } DmNote;
 
 typedef enum DmCurveType {
@@ -237,6 +437,11 @@ typedef enum DmCurveFlags {
 
 typedef struct DmCurve {
 	uint32_t grid_start;
+
+	/// \brief The offset of the curve from the start of the pattern in music time. Resolved from #grid_start and
+	///        #time_offset when the style is parsed.
+	uint32_t offset;
+
 	uint32_t variation;
 	uint32_t duration;
 	uint32_t reset_duration;
@@ -262,9 +467,11 @@ typedef struct DmPart {
 	uint8_t invert_upper;
 	uint8_t invert_lower;
 
+	/// \brief The notes of the part, ordered by their offset.
 	uint32_t note_count;
 	DmNote* notes;
 
+	/// \brief The curves of the part, ordered by their offset.
 	uint32_t curve_count;
 	DmCurve* curves;
 } DmPart;
@@ -321,6 +528,11 @@ DmArray_DEFINE(DmBandList, DmBand*);
 typedef struct DmStyle {
 	_Atomic size_t reference_count;
 	void* backing_memory;
+	size_t backing_length;
+
+	/// \brief Releases #backing_memory if set. Otherwise, it is released using #Dm_free.
+	DmLoaderBufferRelease* backing_release;
+	void* backing_context;
 
 	DmGuid guid;
 	DmUnfo info;
@@ -331,6 +543,9 @@ typedef struct DmStyle {
 	DmBandList bands;
 	DmPartList parts;
 	DmPatternList patterns;
+
+	/// \brief Owns the notes and curves of all parts and the rhythms of all patterns.
+	DmArena arena;
 } DmStyle;
 
 // NOTE: Ordered by priority
@@ -345,6 +560,9 @@ typedef enum DmMessageType {
 	DmMessage_TEMPO,
 	DmMessage_CHORD,
 	DmMessage_COMMAND,
+
+	/// \brief Internal message to generate the next measure of the playing pattern.
+	DmMessage_PATTERN,
 } DmMessageType;
 
 typedef struct DmMessage_Tempo {
@@ -412,6 +630,13 @@ typedef struct DmMessage_Note {
 	uint8_t note;
 	uint8_t velocity;
 	uint32_t channel;
+
+	/// \brief The music value of a note-on message. It is mapped to a MIDI note against the chord playing when the
+	///        message is handled, which also schedules the matching note-off message. Unused for note-off messages.
+	uint16_t music_value;
+	uint8_t play_mode;
+	uint8_t subchord_level;
+	uint32_t duration;
 } DmMessage_Note;
 
 typedef struct DmMessage_Control {
@@ -463,28 +688,52 @@ typedef struct DmSynthFont {
 
 typedef struct DmSynthChannel {
 	DmSynthFont* font;
+
+	/// \brief The performance channel the instruments assigned to this channel are played on.
+	uint32_t pchannel;
+
+	/// \brief The channel of #font used for playback. Equal to the index of this channel in #DmSynth::channels, so
+	///        that fonts only allocate as many channels as are used.
 	int32_t channel;
 	int32_t transpose;
 
+	/// \brief The patch last assigned to the channel in #font. Only valid if #font is set.
+	uint32_t patch;
+
+	/// \brief The volume and pan last sent to the channel in #font or negative if they are not known.
+	float volume;
+	float pan;
+
 	float reset_volume;
 	float reset_pan;
 	int reset_pitch;
 } DmSynthChannel;
 
 DmArray_DEFINE(DmSynthFontArray, DmSynthFont);
+DmArray_DEFINE(DmSynthChannelArray, DmSynthChannel);
 
 typedef struct DmSynth {
 	uint32_t rate;
 	float volume;
 	DmSynthFontArray fonts;
 
-	size_t channels_len;
-	DmSynthChannel* channels;
+	/// \brief The channels instruments have been assigned to, in the order they were first used.
+	DmSynthChannelArray channels;
+
+	/// \brief Maps performance channels to #channels. An open-addressing hash table with a power of two number of
+	///        buckets, each holding an index into #channels plus one or 0 if it is empty.
+	uint32_t* channel_map;
+	size_t channel_map_len;
 } DmSynth;
 
 struct DmSegment {
 	_Atomic size_t reference_count;
 	void* backing_memory;
+	size_t backing_length;
+
+	/// \brief Releases #backing_memory if set. Otherwise, it is released using #Dm_free.
+	DmLoaderBufferRelease* backing_release;
+	void* backing_context;
 
 	/// \brief Number of repetitions.
 	uint32_t repeats;
@@ -511,6 +760,9 @@ struct DmSegment {
 
 	DmMessageList messages;
 
+	/// \brief Owns the names and file names of all style references.
+	DmArena arena;
+
 	bool downloaded;
 };
 
@@ -536,6 +788,48 @@ typedef struct DmMessageQueue {
 	}* blocks;
 } DmMessageQueue;
 
+/// \brief Pre-computed data for mapping music values to MIDI notes using one sub-chord of a chord.
+typedef struct DmSubChordMap {
+	uint32_t chord_pattern;
+	uint32_t scale_pattern;
+	uint32_t levels;
+	uint8_t chord_root;
+	uint8_t chord_bits;
+} DmSubChordMap;
+
+/// \brief Tracks how far the messages of one part of the playing pattern have been generated.
+typedef struct DmPartCursor {
+	DmPart* part;
+	uint32_t variation;
+	uint32_t channel;
+	uint8_t subchord_level;
+
+	/// \brief The index of the next note of #part to generate messages for.
+	uint32_t note;
+
+	/// \brief The index of the next curve of #part to generate messages for.
+	uint32_t curve;
+} DmPartCursor;
+
+DmArray_DEFINE(DmPartCursorList, DmPartCursor);
+
+/// \brief A composed transition segment cached for re-use by #DmPerformance_playTransition.
+typedef struct DmTransitionCacheEntry {
+	DmStyle* style;
+	DmBand* band;
+	DmSegment* target;
+	DmEmbellishmentType embellishment;
+
+	/// \brief The chord the transition was composed for. Transitions are never modified once composed, since a
+	///        queued transition only reads its messages once it starts playing.
+	DmMessage_Chord chord;
+
+	/// \brief The composed transition. Holds references to #style, #band and #target.
+	DmSegment* transition;
+} DmTransitionCacheEntry;
+
+DmArray_DEFINE(DmTransitionCache, DmTransitionCacheEntry);
+
 struct DmPerformance {
 	_Atomic size_t reference_count;
 	mtx_t lock;
@@ -548,6 +842,16 @@ struct DmPerformance {
 	DmStyle* style;
 	DmBand* band;
 	DmSynth synth;
+	DmRandom rng;
+	DmTransitionCache transitions;
+
+	/// \brief The style containing the parts of the playing pattern. Messages for the pattern are generated
+	///        one measure ahead of time, starting at #pattern_start.
+	DmStyle* pattern_style;
+	DmPartCursorList pattern_parts;
+	uint32_t pattern_start;
+	uint32_t pattern_measure;
+	uint32_t pattern_measures;
 
 	uint32_t sample_rate;
 	uint32_t variation;
@@ -557,6 +861,16 @@ struct DmPerformance {
 	double tempo;
 	DmMessage_Chord chord;
 	DmTimeSignature time_signature;
+
+	/// \brief The sub-chords of #chord prepared for music value mapping. Rebuilt whenever the chord changes.
+	DmSubChordMap chord_map[4];
+
+	/// \brief Receives all MIDI events instead of the synthesizer while #DmPerformance_renderEvents is running.
+	DmEventCallback* event_callback;
+	void* event_context;
+
+	/// \brief The frame offset of the message currently being handled, relative to the start of the render call.
+	uint32_t event_frame;
 };
 
 /// \brief Allocate \p len bytes on the heap.
@@ -570,6 +884,34 @@ struct DmPerformance {
 /// \see Dm_setHeapAllocator
 DMINT void* Dm_alloc(size_t len);
 
+/// \brief Allocate \p len bytes on the heap without zeroing them.
+///
+/// Use this instead of #Dm_alloc if the caller overwrites the whole allocation anyway.
+///
+/// \note This function is thread-safe.
+/// \param len The number of bytes to allocate.
+/// \return A pointer to the first allocated byte or `NULL` if allocation failed.
+/// \see Dm_alloc
+DMINT void* Dm_allocUninit(size_t len);
+
+/// \brief Resize a heap-allocated pointer previously allocated by #Dm_alloc or #Dm_allocUninit.
+///
+/// Uses the user-provided re-allocation function if one was set. Otherwise, a new block is allocated and the
+/// contents of the old one are copied over. Bytes past \p old_len are not zeroed.
+///
+/// \note This function is thread-safe.
+/// \param ptr A pointer to the memory to resize or `NULL`.
+/// \param old_len The current size of the memory block in bytes.
+/// \param len The new size of the memory block in bytes.
+/// \return A pointer to the first byte of the resized block or `NULL` if allocation failed, in which case \p ptr
+///         remains valid.
+/// \see Dm_setHeapReallocator
+DMINT void* Dm_realloc(void* ptr, size_t old_len, size_t len);
+
+/// \brief Get the number of allocations and allocated bytes made by the calling thread so far.
+/// \note Freeing memory does not decrease the counters. Only differences between two calls are meaningful.
+DMINT void Dm_getAllocationCounters(size_t* count, size_t* bytes);
+
 /// \brief Free a heap-allocated pointer previously allocated by #Dm_alloc
 ///
 /// If set, this function will automatically choose a user-provided allocator over a the default one.
@@ -580,6 +922,36 @@ DMINT void* Dm_alloc(size_t len);
 /// \see Dm_setHeapAllocator
 DMINT void Dm_free(void* ptr);
 
+/// \brief Release a buffer returned by a resolver.
+///
+/// \param buf A pointer to the buffer to release or `NULL`.
+/// \param len The length of the buffer in bytes.
+/// \param release The release function returned by the resolver or `NULL` if the buffer should be released using
+///                #Dm_free.
+/// \param ctx The context pointer returned by the resolver.
+DMINT void Dm_releaseBuffer(void* buf, size_t len, DmLoaderBufferRelease* release, void* ctx);
+
+/// \brief Read one byte from every page of the given buffer, so that it is paged in.
+DMINT void Dm_touchMemory(void const* buf, size_t len);
+
+/// \brief Reserve zeroed memory which is only backed by physical memory once it is used.
+/// \note Memory reserved using this function bypasses the allocator set using #Dm_setHeapAllocator.
+/// \note Every range must be committed using #Dm_commitMemory before it is accessed.
+DMINT void* Dm_reserveMemory(size_t len);
+
+/// \brief Commit a range of memory reserved using #Dm_reserveMemory, so that it can be accessed.
+/// \return `true` if the range was committed and `false` if the system is out of memory.
+DMINT bool Dm_commitMemory(void* buf, size_t len);
+
+/// \brief Release memory reserved using #Dm_reserveMemory. Does nothing if \p buf is `NULL`.
+DMINT void Dm_releaseMemory(void* buf, size_t len);
+
+/// \brief Get the current value of a monotonic clock in nanoseconds.
+DMINT uint64_t Dm_getMonotonicTime(void);
+
+/// \brief Get the time in seconds between two values returned by #Dm_getMonotonicTime.
+DMINT double Dm_getElapsedSeconds(uint64_t start, uint64_t end);
+
 /// \brief Generate a log message at the given level.
 /// \invariant \p fmt may not be `NULL`.
 /// \param lvl The level of the log message to generate.
@@ -595,14 +967,65 @@ DMINT void Dm_report(DmLogLevel lvl, char const* fmt, ...);
 /// \see Dm_setRandomNumberGenerator
 DMINT uint32_t Dm_rand(void);
 
+/// \brief Seed a pseudo-random number generator.
+/// \param slf The generator to seed.
+/// \param seed The seed value. Equal seeds produce equal sequences.
+DMINT void DmRandom_init(DmRandom* slf, uint64_t seed);
+
+/// \brief Generate the next random number in the range 0 to UINT32_MAX from the given generator.
+/// \param slf The generator to advance.
+/// \return A random number.
+DMINT uint32_t DmRandom_next(DmRandom* slf);
+
 DMINT size_t max_usize(size_t a, size_t b);
+DMINT size_t min_usize(size_t a, size_t b);
 DMINT int32_t max_s32(int32_t a, int32_t b);
 DMINT uint8_t min_u8(uint8_t a, uint8_t b);
 DMINT float lerp(float x, float start, float end);
 DMINT int32_t clamp_s32(int32_t val, int32_t min, int32_t max);
-DMINT int32_t Dm_randRange(int32_t range);
+DMINT int32_t Dm_randRange(DmRandom* rng, int32_t range);
 DMINT DmCommandType Dm_embellishmentToCommand(DmEmbellishmentType embellishment);
 DMINT bool DmGuid_equals(DmGuid const* a, DmGuid const* b);
+
+DMINT DmResult DmCache_init(DmCache* slf, DmCacheRetain* retain, DmCacheRelease* release, DmCacheUnused* unused);
+DMINT void DmCache_free(DmCache* slf);
+DMINT DmCacheEntry* DmCache_find(DmCache* slf, DmGuid const* guid, char const* file);
+DMINT DmResult DmCache_insert(DmCache* slf, DmGuid const* guid, char const* file, DmCacheEntry** out);
+DMINT void DmCache_remove(DmCache* slf, DmCacheEntry* entry);
+DMINT void DmCache_clear(DmCache* slf);
+DMINT void DmCache_touch(DmCache* slf, DmCacheEntry* entry);
+DMINT DmCacheEntry* DmCache_findEvictable(DmCache* slf);
+DMINT void DmCacheEntry_free(DmCacheEntry* slf);
+DMINT uint64_t DmCache_hashData(void const* data, size_t len);
+DMINT uint64_t DmCache_hashFile(char const* file);
+DMINT bool DmCache_fileEquals(char const* a, char const* b);
+
+DMINT void* Dm_mapFile(char const* path, size_t* len);
+DMINT void Dm_unmapFile(void* ctx, void* buf, size_t len);
+
+DMINT DmResult DmDirectory_open(DmDirectory** slf, char const* path);
+DMINT void DmDirectory_close(void* ctx);
+DMINT void* DmDirectory_resolve(void* ctx,
+                                char const* file,
+                                size_t* len,
+                                DmLoaderBufferRelease** release,
+                                void** release_ctx);
+DMINT size_t DmDirectory_getFileCount(DmDirectory* slf);
+DMINT void DmDirectory_visit(DmDirectory* slf, DmDirectoryVisitor* visit, void* ctx);
+
+DMINT DmResult DmPack_open(DmPack** slf, char const* path);
+DMINT DmPack* DmPack_retain(DmPack* slf);
+DMINT void DmPack_release(void* ctx);
+DMINT void* DmPack_resolve(void* ctx,
+                           char const* file,
+                           size_t* len,
+                           DmLoaderBufferRelease** release,
+                           void** release_ctx);
+
+DMINT DmResult DmWorkerPool_create(DmWorkerPool** slf, size_t threads);
+DMINT void DmWorkerPool_destroy(DmWorkerPool* slf);
+DMINT DmResult DmWorkerPool_submit(DmWorkerPool* slf, DmWorkerFunc* run, void* ctx);
+DMINT void Dm_runParallel(size_t count, size_t grain, DmParallelFunc* run, void* ctx);
 DMINT void DmTimeSignature_parse(DmTimeSignature* slf, DmRiff* rif);
 
 DMINT uint32_t Dm_getBeatLength(DmTimeSignature sig);
@@ -626,6 +1049,7 @@ DMINT DmResult DmLoader_getDownloadableSound(DmLoader* slf, DmReference const* r
 
 DMINT DmResult DmSegment_create(DmSegment** slf);
 DMINT DmResult DmSegment_parse(DmSegment* slf, void* buf, size_t len);
+DMINT DmResult DmSegment_probe(DmSegmentInfo* slf, void const* buf, size_t len);
 
 DMINT void DmMessage_copy(DmMessage* slf, DmMessage* cpy, int64_t time);
 DMINT void DmMessage_free(DmMessage* slf);
@@ -650,10 +1074,9 @@ DMINT void DmStyle_release(DmStyle* slf);
 DMINT DmResult DmStyle_parse(DmStyle* slf, void* buf, size_t len);
 DMINT DmResult DmStyle_download(DmStyle* slf, DmLoader* loader);
 DMINT DmPart* DmStyle_findPart(DmStyle* slf, DmPartReference* pref);
-DMINT DmPattern* DmStyle_getRandomPattern(DmStyle* slf, uint32_t groove, DmCommandType cmd);
+DMINT DmPattern* DmStyle_getRandomPattern(DmStyle* slf, DmRandom* rng, uint32_t groove, DmCommandType cmd);
 
 DMINT void DmPart_init(DmPart* slf);
-DMINT void DmPart_free(DmPart* slf);
 DMINT uint32_t DmPart_getValidVariationCount(DmPart* slf);
 
 DMINT void DmPartReference_init(DmPartReference* slf);
@@ -667,7 +1090,13 @@ DMINT void DmSynth_free(DmSynth* slf);
 DMINT void DmSynth_reset(DmSynth* slf);
 
 DMINT void DmSynth_setVolume(DmSynth* slf, float vol);
-DMINT DmResult DmSynth_createTsfForDls(DmDls* dls, tsf** out);
+DMINT DmResult DmSynth_createTsfForDls(DmDls* dls, tsf** out, size_t* sample_count);
+DMINT DmResult DmDls_getFont(DmDls* slf, tsf** out);
+DMINT void DmDls_closeFont(DmDls* slf, tsf* fnt);
+DMINT DmResult DmDls_decodePreset(DmDls* slf, tsf const* fnt, int preset);
+DMINT void DmDls_detachFontMemory(DmDls* slf);
+DMINT bool DmDls_loadFontCache(DmDls* slf, tsf** out);
+DMINT void DmDls_saveFontCache(DmDls* slf, tsf const* fnt, size_t sample_count);
 DMINT void DmSynth_sendBandUpdate(DmSynth* slf, DmBand* band);
 DMINT void DmSynth_sendControl(DmSynth* slf, uint32_t channel, uint8_t control, float value);
 DMINT void DmSynth_sendControlReset(DmSynth* slf, uint32_t channel, uint8_t control, float reset);
@@ -1,6 +1,8 @@
 // Copyright © 2024. GothicKit Contributors
 // SPDX-License-Identifier: MIT-Modern-Variant
 #pragma once
+#include "util/Arena.h"
+
 #include <stdbool.h>
 
 #define DM_FOURCC(a, b, c, d) (((d) << 24U) | ((c) << 16U) | ((b) << 8U) | (a))
@@ -94,8 +96,12 @@ typedef struct DmVersion {
 	uint32_t ls;
 } DmVersion;
 
+enum {
+	DmInt_UNFO_NAME_LENGTH = 128,
+};
+
 typedef struct DmUnfo {
-	char const* unam;
+	char unam[DmInt_UNFO_NAME_LENGTH];
 } DmUnfo;
 
 typedef struct DmInfo {
@@ -121,9 +127,9 @@ DMINT void DmGuid_parse(DmGuid* slf, DmRiff* rif);
 DMINT void DmUnfo_parse(DmUnfo* slf, DmRiff* rif);
 DMINT void DmInfo_parse(DmInfo* slf, DmRiff* rif);
 DMINT void DmVersion_parse(DmVersion* slf, DmRiff* rif);
-DMINT void DmReference_parse(DmReference* slf, DmRiff* rif);
+DMINT void DmReference_parse(DmReference* slf, DmRiff* rif, DmArena* arena);
 
-DMINT char* Dm_utf16ToUtf8Inline(char* out, uint16_t const* u16);
+DMINT void Dm_utf16ToUtf8(char* out, size_t out_len, uint8_t const* u16, size_t len);
 
 DMINT bool DmRiff_init(DmRiff* slf, void const* buf, size_t len);
 DMINT bool DmRiff_is(DmRiff const* slf, uint32_t id, uint32_t typ);
@@ -7,7 +7,7 @@ enum {
 	DmBand_MAX_VOLUME = 127,
 };
 
-static void DmBand_parseInstrument(DmInstrument* slf, DmRiff* rif) {
+static void DmBand_parseInstrument(DmInstrument* slf, DmRiff* rif, DmArena* arena) {
 	DmRiff cnk;
 	while (DmRiff_readChunk(rif, &cnk)) {
 		if (DmRiff_is(&cnk, DM_FOURCC_BINS, 0)) {
@@ -27,7 +27,7 @@ static void DmBand_parseInstrument(DmInstrument* slf, DmRiff* rif) {
 			slf->pan = min_u8(slf->pan, DmBand_MAX_PAN);
 			slf->volume = min_u8(slf->volume, DmBand_MAX_VOLUME);
 		} else if (DmRiff_is(&cnk, DM_FOURCC_LIST, DM_FOURCC_DMRF)) {
-			DmReference_parse(&slf->reference, &cnk);
+			DmReference_parse(&slf->reference, &cnk, arena);
 		}
 
 		DmRiff_reportDone(&cnk);
@@ -51,7 +51,7 @@ static DmResult DmBand_parseInstrumentList(DmBand* slf, DmRiff* rif) {
 			return DmResult_FILE_CORRUPT;
 		}
 
-		DmBand_parseInstrument(&slf->instruments[i], &cnk);
+		DmBand_parseInstrument(&slf->instruments[i], &cnk, &slf->arena);
 		DmRiff_reportDone(&cnk);
 	}
 
@@ -2,37 +2,72 @@
 // SPDX-License-Identifier: MIT-Modern-Variant
 #include "_Internal.h"
 
-#include <wchar.h>
-
 void DmGuid_parse(DmGuid* slf, DmRiff* rif) {
 	DmRiff_read(rif, slf->data, sizeof slf->data);
 }
 
-char* Dm_utf16ToUtf8Inline(char* out, uint16_t const* u16) {
-	size_t len = 0;
-	while (u16[len] != 0) {
-		len += 1;
-	}
-
-	mbstate_t state;
-	memset(&state, 0, sizeof state);
+static uint32_t Dm_readUtf16(uint8_t const* u16, size_t i) {
+	return (uint32_t) u16[i * 2] | (uint32_t) u16[i * 2 + 1] << 8;
+}
 
-	size_t i = 0;
+// Converts at most `len` code units of a nul-terminated UTF-16LE string. The output is truncated at a code point
+// boundary if it doesn't fit into `out` and unpaired surrogates are replaced with U+FFFD.
+void Dm_utf16ToUtf8(char* out, size_t out_len, uint8_t const* u16, size_t len) {
 	size_t j = 0;
-	for (; i < len; ++i) {
-		j += wcrtomb(out + j, u16[i], &state);
+	for (size_t i = 0; i < len; ++i) {
+		uint32_t cp = Dm_readUtf16(u16, i);
+		if (cp == 0) {
+			break;
+		}
+
+		if (cp >= 0xD800 && cp <= 0xDBFF && i + 1 < len) {
+			uint32_t low = Dm_readUtf16(u16, i + 1);
+			if (low >= 0xDC00 && low <= 0xDFFF) {
+				cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+				i += 1;
+			}
+		}
+
+		if (cp >= 0xD800 && cp <= 0xDFFF) {
+			cp = 0xFFFD;
+		}
+
+		uint8_t enc[4];
+		size_t n = 0;
+		if (cp < 0x80) {
+			enc[n++] = (uint8_t) cp;
+		} else if (cp < 0x800) {
+			enc[n++] = (uint8_t) (0xC0 | cp >> 6);
+			enc[n++] = (uint8_t) (0x80 | (cp & 0x3F));
+		} else if (cp < 0x10000) {
+			enc[n++] = (uint8_t) (0xE0 | cp >> 12);
+			enc[n++] = (uint8_t) (0x80 | (cp >> 6 & 0x3F));
+			enc[n++] = (uint8_t) (0x80 | (cp & 0x3F));
+		} else {
+			enc[n++] = (uint8_t) (0xF0 | cp >> 18);
+			enc[n++] = (uint8_t) (0x80 | (cp >> 12 & 0x3F));
+			enc[n++] = (uint8_t) (0x80 | (cp >> 6 & 0x3F));
+			enc[n++] = (uint8_t) (0x80 | (cp & 0x3F));
+		}
+
+		if (j + n >= out_len) {
+			break;
+		}
+
+		memcpy(out + j, enc, n);
+		j += n;
 	}
 
 	out[j] = '\0';
-	return out;
 }
 
+// The name is converted into the object itself, since the file's memory might be mapped read-only or shared between
+// multiple objects loaded from it.
 void DmUnfo_parse(DmUnfo* slf, DmRiff* rif) {
 	DmRiff cnk;
 	while (DmRiff_readChunk(rif, &cnk)) {
 		if (DmRiff_is(&cnk, DM_FOURCC_UNAM, 0)) {
-			uint16_t* raw = DmRiff_readStringUtf(&cnk);
-			slf->unam = Dm_utf16ToUtf8Inline((char*) raw, raw);
+			Dm_utf16ToUtf8(slf->unam, sizeof slf->unam, cnk.mem, cnk.len / 2);
 		} else {
 			DmRiff_reportDone(&cnk);
 		}
@@ -67,7 +102,17 @@ void DmVersion_parse(DmVersion* slf, DmRiff* rif) {
 	DmRiff_readDword(rif, &slf->ls);
 }
 
-void DmReference_parse(DmReference* slf, DmRiff* rif) {
+// A UTF-16 code unit never takes up more than three bytes in UTF-8; surrogate pairs take up four bytes for two units.
+static char const* DmReference_parseString(DmRiff* rif, DmArena* arena) {
+	size_t len = rif->len / 2;
+	char* str = DmArena_alloc(arena, len * 3 + 1);
+	if (str != NULL) {
+		Dm_utf16ToUtf8(str, len * 3 + 1, rif->mem, len);
+	}
+	return str;
+}
+
+void DmReference_parse(DmReference* slf, DmRiff* rif, DmArena* arena) {
 	DmRiff cnk;
 	while (DmRiff_readChunk(rif, &cnk)) {
 		if (DmRiff_is(&cnk, DM_FOURCC_REFH, 0)) {
@@ -76,12 +121,10 @@ void DmReference_parse(DmReference* slf, DmRiff* rif) {
 		} else if (DmRiff_is(&cnk, DM_FOURCC_GUID, 0)) {
 			DmGuid_parse(&slf->guid, &cnk);
 		} else if (DmRiff_is(&cnk, DM_FOURCC_NAME, 0)) {
-			uint16_t* raw = DmRiff_readStringUtf(&cnk);
-			slf->name = Dm_utf16ToUtf8Inline((char*) raw, raw);
+			slf->name = DmReference_parseString(&cnk, arena);
 			continue; // Ignore following bytes
 		} else if (DmRiff_is(&cnk, DM_FOURCC_FILE, 0)) {
-			uint16_t* raw = DmRiff_readStringUtf(&cnk);
-			slf->file = Dm_utf16ToUtf8Inline((char*) raw, raw);
+			slf->file = DmReference_parseString(&cnk, arena);
 			continue; // Ignore following bytes
 		} else if (DmRiff_is(&cnk, DM_FOURCC_VERS, 0)) {
 			DmVersion_parse(&slf->version, &cnk);
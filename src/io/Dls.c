@@ -68,12 +68,12 @@ static DmDlsArticulatorTransform DmDls_convertArticulatorTransform(uint16_t tran
 		}
 }
 
-static DmResult DmDls_parseArticulator(DmDlsArticulator* slf, DmRiff* rif) {
+static DmResult DmDls_parseArticulator(DmDlsArticulator* slf, DmRiff* rif, DmArena* arena) {
 	uint32_t struct_size = 0;
 	DmRiff_readDword(rif, &struct_size);
 
 	DmRiff_readDword(rif, &slf->connection_count);
-	slf->connections = Dm_alloc(slf->connection_count * sizeof(*slf->connections));
+	slf->connections = DmArena_alloc(arena, slf->connection_count * sizeof(*slf->connections));
 	if (slf->connections == NULL) {
 		Dm_report(DmLogLevel_FATAL,
 		          "DmDls: Failed to allocate %d connection blocks for articulator",
@@ -110,7 +110,7 @@ static DmResult DmDls_parseArticulator(DmDlsArticulator* slf, DmRiff* rif) {
 	return DmResult_SUCCESS;
 }
 
-static DmResult DmDls_parseArticulatorList(DmDlsArticulator* lst, DmRiff* rif, size_t len) {
+static DmResult DmDls_parseArticulatorList(DmDlsArticulator* lst, DmRiff* rif, size_t len, DmArena* arena) {
 	DmRiff cnk;
 	for (size_t i = 0; i < len; ++i) {
 		if (!DmRiff_readChunk(rif, &cnk)) {
@@ -126,7 +126,7 @@ static DmResult DmDls_parseArticulatorList(DmDlsArticulator* lst, DmRiff* rif, s
 		DmDlsArticulator_init(&lst[i]);
 		lst[i].level = level2 ? 2 : 1;
 
-		DmResult rv = DmDls_parseArticulator(&lst[i], &cnk);
+		DmResult rv = DmDls_parseArticulator(&lst[i], &cnk, arena);
 		if (rv != DmResult_SUCCESS) {
 			return rv;
 		}
@@ -137,7 +137,7 @@ static DmResult DmDls_parseArticulatorList(DmDlsArticulator* lst, DmRiff* rif, s
 	return DmResult_SUCCESS;
 }
 
-static DmResult DmDls_parseRegion(DmDlsRegion* slf, DmRiff* rif) {
+static DmResult DmDls_parseRegion(DmDlsRegion* slf, DmRiff* rif, DmArena* arena) {
 	DmRiff cnk;
 	while (DmRiff_readChunk(rif, &cnk)) {
 		if (DmRiff_is(&cnk, DM_FOURCC_RGNH, 0)) {
@@ -170,23 +170,15 @@ static DmResult DmDls_parseRegion(DmDlsRegion* slf, DmRiff* rif) {
 				continue;
 			}
 
-			// If we're overriding lart, we need to free all the exising articulators
-			if (slf->articulators != NULL) {
-				for (size_t i = 0; i < slf->articulator_count; ++i) {
-					DmDlsArticulator_free(&slf->articulators[i]);
-				}
-
-				Dm_free(slf->articulators);
-			}
-
+			// If we're overriding lart, the existing articulators are left in the arena.
 			slf->articulator_count = DmRiff_chunks(&cnk);
-			slf->articulators = Dm_alloc(slf->articulator_count * sizeof(DmDlsArticulator));
+			slf->articulators = DmArena_alloc(arena, slf->articulator_count * sizeof(DmDlsArticulator));
 
 			if (slf->articulators == NULL) {
 				return DmResult_MEMORY_EXHAUSTED;
 			}
 
-			DmResult rv = DmDls_parseArticulatorList(slf->articulators, &cnk, slf->articulator_count);
+			DmResult rv = DmDls_parseArticulatorList(slf->articulators, &cnk, slf->articulator_count, arena);
 			if (rv != DmResult_SUCCESS) {
 				return rv;
 			}
@@ -198,8 +190,8 @@ static DmResult DmDls_parseRegion(DmDlsRegion* slf, DmRiff* rif) {
 	return DmResult_SUCCESS;
 }
 
-static DmResult DmDls_parseInstrumentRegionList(DmDlsInstrument* slf, DmRiff* rif) {
-	slf->regions = Dm_alloc(slf->region_count * sizeof(DmDlsRegion));
+static DmResult DmDls_parseInstrumentRegionList(DmDlsInstrument* slf, DmRiff* rif, DmArena* arena) {
+	slf->regions = DmArena_alloc(arena, slf->region_count * sizeof(DmDlsRegion));
 	if (slf->regions == NULL) {
 		return DmResult_MEMORY_EXHAUSTED;
 	}
@@ -215,7 +207,7 @@ static DmResult DmDls_parseInstrumentRegionList(DmDlsInstrument* slf, DmRiff* ri
 		}
 
 		DmDlsRegion_init(&slf->regions[i]);
-		DmResult rv = DmDls_parseRegion(&slf->regions[i], &cnk);
+		DmResult rv = DmDls_parseRegion(&slf->regions[i], &cnk, arena);
 		if (rv != DmResult_SUCCESS) {
 			return rv;
 		}
@@ -226,7 +218,7 @@ static DmResult DmDls_parseInstrumentRegionList(DmDlsInstrument* slf, DmRiff* ri
 	return DmResult_SUCCESS;
 }
 
-static DmResult DmDls_parseInstrument(DmDlsInstrument* slf, DmRiff* rif) {
+static DmResult DmDls_parseInstrument(DmDlsInstrument* slf, DmRiff* rif, DmArena* arena) {
 	DmRiff cnk;
 	while (DmRiff_readChunk(rif, &cnk)) {
 		DmResult rv = DmResult_SUCCESS;
@@ -240,29 +232,22 @@ static DmResult DmDls_parseInstrument(DmDlsInstrument* slf, DmRiff* rif) {
 		} else if (DmRiff_is(&cnk, DM_FOURCC_LIST, DM_FOURCC_INFO)) {
 			DmInfo_parse(&slf->info, &cnk);
 		} else if (DmRiff_is(&cnk, DM_FOURCC_LIST, DM_FOURCC_LRGN)) {
-			rv = DmDls_parseInstrumentRegionList(slf, &cnk);
+			rv = DmDls_parseInstrumentRegionList(slf, &cnk, arena);
 		} else if (DmRiff_is(&cnk, DM_FOURCC_LIST, DM_FOURCC_LART) || DmRiff_is(&cnk, DM_FOURCC_LIST, DM_FOURCC_LAR2)) {
 			// We can only accept either lart or lar2, not both. lar2 takes precedence, though.
 			if (slf->articulator_count != 0 && !DmRiff_is(&cnk, DM_FOURCC_LIST, DM_FOURCC_LAR2)) {
 				continue;
 			}
 
-			// If we're overriding lart, we need to free all the exising articulators
-			if (slf->articulators != NULL) {
-				for (size_t i = 0; i < slf->articulator_count; ++i) {
-					DmDlsArticulator_free(&slf->articulators[i]);
-				}
-
-				Dm_free(slf->articulators);
-			}
+			// If we're overriding lart, the existing articulators are left in the arena.
 			slf->articulator_count = DmRiff_chunks(&cnk);
-			slf->articulators = Dm_alloc(slf->articulator_count * sizeof(DmDlsArticulator));
+			slf->articulators = DmArena_alloc(arena, slf->articulator_count * sizeof(DmDlsArticulator));
 
 			if (slf->articulators == NULL) {
 				return DmResult_MEMORY_EXHAUSTED;
 			}
 
-			rv = DmDls_parseArticulatorList(slf->articulators, &cnk, slf->articulator_count);
+			rv = DmDls_parseArticulatorList(slf->articulators, &cnk, slf->articulator_count, arena);
 		}
 
 		if (rv != DmResult_SUCCESS) {
@@ -275,15 +260,73 @@ static DmResult DmDls_parseInstrument(DmDlsInstrument* slf, DmRiff* rif) {
 	return DmResult_SUCCESS;
 }
 
+// Reads a little-endian dword at the given offset of a chunk without reporting chunks which are too short. Those are
+// reported once they are actually parsed.
+static uint32_t DmDls_peekDword(DmRiff const* rif, uint32_t offset) {
+	uint32_t value = 0;
+	if (rif->len >= offset + sizeof value) {
+		memcpy(&value, rif->mem + offset, sizeof value);
+	}
+
+	return value;
+}
+
+static size_t DmDls_measureArticulatorList(DmRiff* rif) {
+	size_t size = DmArena_measure(DmRiff_chunks(rif) * sizeof(DmDlsArticulator));
+
+	DmRiff cnk;
+	while (DmRiff_readChunk(rif, &cnk)) {
+		uint32_t connection_count = DmDls_peekDword(&cnk, 4);
+		size += DmArena_measure(connection_count * sizeof(struct DmDlsArticulatorConnection));
+	}
+
+	return size;
+}
+
+// Measures the arena memory needed to parse an instrument. Mirrors the allocations made while parsing, so that all
+// of them fit into the arena for well-formed files.
+static size_t DmDls_measureInstrument(DmRiff rif) {
+	uint32_t region_count = 0;
+	size_t size = 0;
+
+	DmRiff cnk;
+	while (DmRiff_readChunk(&rif, &cnk)) {
+		if (DmRiff_is(&cnk, DM_FOURCC_INSH, 0)) {
+			region_count = DmDls_peekDword(&cnk, 0);
+		} else if (DmRiff_is(&cnk, DM_FOURCC_LIST, DM_FOURCC_LRGN)) {
+			size += DmArena_measure(region_count * sizeof(DmDlsRegion));
+
+			DmRiff rgn;
+			while (DmRiff_readChunk(&cnk, &rgn)) {
+				DmRiff art;
+				while (DmRiff_readChunk(&rgn, &art)) {
+					if (DmRiff_is(&art, DM_FOURCC_LIST, DM_FOURCC_LART) ||
+					    DmRiff_is(&art, DM_FOURCC_LIST, DM_FOURCC_LAR2)) {
+						size += DmDls_measureArticulatorList(&art);
+					}
+				}
+			}
+		} else if (DmRiff_is(&cnk, DM_FOURCC_LIST, DM_FOURCC_LART) || DmRiff_is(&cnk, DM_FOURCC_LIST, DM_FOURCC_LAR2)) {
+			size += DmDls_measureArticulatorList(&cnk);
+		}
+	}
+
+	return size;
+}
+
 static DmResult DmDls_parseInstrumentList(DmDls* slf, DmRiff* rif) {
 	slf->instruments = Dm_alloc(slf->instrument_count * sizeof(DmDlsInstrument));
 	if (slf->instruments == NULL) {
 		return DmResult_MEMORY_EXHAUSTED;
 	}
 
+	// All regions, articulators and connections of the collection are allocated from a single arena, so the
+	// instruments are measured using a copy of the list before they are parsed.
+	DmRiff lst = *rif;
 	DmRiff cnk;
+	size_t arena_size = 0;
 	for (size_t i = 0; i < slf->instrument_count; ++i) {
-		if (!DmRiff_readChunk(rif, &cnk)) {
+		if (!DmRiff_readChunk(&lst, &cnk)) {
 			return DmResult_FILE_CORRUPT;
 		}
 
@@ -291,7 +334,19 @@ static DmResult DmDls_parseInstrumentList(DmDls* slf, DmRiff* rif) {
 			return DmResult_FILE_CORRUPT;
 		}
 
-		DmResult rv = DmDls_parseInstrument(&slf->instruments[i], &cnk);
+		arena_size += DmDls_measureInstrument(cnk);
+	}
+
+	DmArena_free(&slf->arena);
+	DmResult rv = DmArena_init(&slf->arena, arena_size);
+	if (rv != DmResult_SUCCESS) {
+		return rv;
+	}
+
+	for (size_t i = 0; i < slf->instrument_count; ++i) {
+		(void) DmRiff_readChunk(rif, &cnk);
+
+		rv = DmDls_parseInstrument(&slf->instruments[i], &cnk, &slf->arena);
 		if (rv != DmResult_SUCCESS) {
 			return rv;
 		}
@@ -423,16 +478,15 @@ static DmResult DmDls_parseWaveTable(DmDls* slf, DmRiff* rif) {
 }
 
 DmResult DmDls_parse(DmDls* slf, void* buf, size_t len) {
+	slf->backing_memory = buf;
+	slf->backing_length = len;
+
 	DmRiff rif;
 	if (!DmRiff_init(&rif, buf, len)) {
-		Dm_free(buf);
-
 		Dm_report(DmLogLevel_FATAL, "Dls: File corrupted");
 		return DmResult_FILE_CORRUPT;
 	}
 
-	slf->backing_memory = buf;
-
 	DmRiff cnk;
 	while (DmRiff_readChunk(&rif, &cnk)) {
 		DmResult rv = DmResult_SUCCESS;
@@ -8,6 +8,11 @@ static DmResult DmSegment_parseTempoTrack(DmMessageList* slf, DmRiff* rif) {
 
 	DmMessage msg;
 	uint32_t item_count = (rif->len - rif->pos) / item_size;
+	DmResult rv = DmMessageList_reserve(slf, slf->length + item_count);
+	if (rv != DmResult_SUCCESS) {
+		return rv;
+	}
+
 	for (uint32_t i = 0; i < item_count; ++i) {
 		uint32_t end_position = rif->pos + item_size;
 
@@ -21,7 +26,7 @@ static DmResult DmSegment_parseTempoTrack(DmMessageList* slf, DmRiff* rif) {
 
 		DmRiff_readDouble(rif, &msg.tempo.tempo);
 
-		DmResult rv = DmMessageList_add(slf, msg);
+		rv = DmMessageList_add(slf, msg);
 		if (rv != DmResult_SUCCESS) {
 			return rv;
 		}
@@ -74,12 +79,17 @@ static DmResult DmSegment_parseCommandTrack(DmMessageList* slf, DmRiff* rif) {
 
 	DmMessage msg;
 	uint32_t item_count = (rif->len - rif->pos) / item_size;
+	DmResult rv = DmMessageList_reserve(slf, slf->length + item_count);
+	if (rv != DmResult_SUCCESS) {
+		return rv;
+	}
+
 	for (uint32_t i = 0; i < item_count; ++i) {
 		uint32_t end_position = rif->pos + item_size;
 
 		DmSegment_parseCommandItem(&msg.command, rif);
 
-		DmResult rv = DmMessageList_add(slf, msg);
+		rv = DmMessageList_add(slf, msg);
 		if (rv != DmResult_SUCCESS) {
 			return rv;
 		}
@@ -101,9 +111,9 @@ static void DmSegment_parseChordItem(DmMessage_Chord* slf, DmRiff* rif) {
 	{
 		uint32_t end_position = rif->pos + item_size;
 
-		uint16_t name[16];
-		DmRiff_read(rif, name, 16 * sizeof(int16_t));
-		(void) Dm_utf16ToUtf8Inline(slf->name, name);
+		uint8_t name[16 * sizeof(uint16_t)] = {0};
+		DmRiff_read(rif, name, sizeof name);
+		Dm_utf16ToUtf8(slf->name, sizeof slf->name, name, 16);
 
 		DmRiff_readDword(rif, &slf->time);
 		DmRiff_readWord(rif, &slf->measure);
@@ -186,6 +196,8 @@ static DmResult DmSegment_parseBandItem(DmMessage_Band* slf, DmRiff* rif) {
 				DmBand_release(slf->band);
 				return rv;
 			}
+
+			slf->band->hash = DmCache_hashData(cnk.mem, cnk.len);
 		}
 
 		DmRiff_reportDone(&cnk);
@@ -232,7 +244,7 @@ static DmResult DmSegment_parseBandTrack(DmMessageList* slf, DmRiff* rif) {
 	return DmResult_SUCCESS;
 }
 
-static void DmSegment_parseStyleItem(DmMessage_Style* slf, DmRiff* rif) {
+static void DmSegment_parseStyleItem(DmMessage_Style* slf, DmRiff* rif, DmArena* arena) {
 	memset(slf, 0, sizeof *slf);
 	slf->type = DmMessage_STYLE;
 
@@ -241,19 +253,19 @@ static void DmSegment_parseStyleItem(DmMessage_Style* slf, DmRiff* rif) {
 		if (DmRiff_is(&cnk, DM_FOURCC_STMP, 0)) {
 			DmRiff_readDword(&cnk, &slf->time);
 		} else if (DmRiff_is(&cnk, DM_FOURCC_LIST, DM_FOURCC_DMRF)) {
-			DmReference_parse(&slf->reference, &cnk);
+			DmReference_parse(&slf->reference, &cnk, arena);
 		}
 
 		DmRiff_reportDone(&cnk);
 	}
 }
 
-static DmResult DmSegment_parseStyleTrack(DmMessageList* slf, DmRiff* rif) {
+static DmResult DmSegment_parseStyleTrack(DmMessageList* slf, DmRiff* rif, DmArena* arena) {
 	DmMessage msg;
 	DmRiff cnk;
 	while (DmRiff_readChunk(rif, &cnk)) {
 		if (DmRiff_is(&cnk, DM_FOURCC_LIST, DM_FOURCC_STRF)) {
-			DmSegment_parseStyleItem(&msg.style, &cnk);
+			DmSegment_parseStyleItem(&msg.style, &cnk, arena);
 
 			DmResult rv = DmMessageList_add(slf, msg);
 			if (rv != DmResult_SUCCESS) {
@@ -267,7 +279,7 @@ static DmResult DmSegment_parseStyleTrack(DmMessageList* slf, DmRiff* rif) {
 	return DmResult_SUCCESS;
 }
 
-static DmResult DmSegment_parseTrack(DmMessageList* slf, DmRiff* rif) {
+static DmResult DmSegment_parseTrack(DmMessageList* slf, DmRiff* rif, DmArena* arena) {
 	DmGuid class_id;
 	uint32_t position;
 	uint32_t group;
@@ -290,7 +302,7 @@ static DmResult DmSegment_parseTrack(DmMessageList* slf, DmRiff* rif) {
 		} else if (DmRiff_is(&cnk, DM_FOURCC_LIST, DM_FOURCC_CORD)) {
 			rv = DmSegment_parseChordTrack(slf, &cnk);
 		} else if (DmRiff_is(&cnk, DM_FOURCC_LIST, DM_FOURCC_STTR)) {
-			rv = DmSegment_parseStyleTrack(slf, &cnk);
+			rv = DmSegment_parseStyleTrack(slf, &cnk, arena);
 		} else if (DmRiff_is(&cnk, DM_FOURCC_RIFF, DM_FOURCC_DMBT)) {
 			rv = DmSegment_parseBandTrack(slf, &cnk);
 		}
@@ -305,11 +317,11 @@ static DmResult DmSegment_parseTrack(DmMessageList* slf, DmRiff* rif) {
 	return DmResult_SUCCESS;
 }
 
-static DmResult DmSegment_parseTrackList(DmMessageList* slf, DmRiff* rif) {
+static DmResult DmSegment_parseTrackList(DmMessageList* slf, DmRiff* rif, DmArena* arena) {
 	DmRiff cnk;
 	while (DmRiff_readChunk(rif, &cnk)) {
 		if (DmRiff_is(&cnk, DM_FOURCC_RIFF, DM_FOURCC_DMTK)) {
-			DmResult rv = DmSegment_parseTrack(slf, &cnk);
+			DmResult rv = DmSegment_parseTrack(slf, &cnk, arena);
 			if (rv != DmResult_SUCCESS) {
 				return rv;
 			}
@@ -322,14 +334,14 @@ static DmResult DmSegment_parseTrackList(DmMessageList* slf, DmRiff* rif) {
 }
 
 DmResult DmSegment_parse(DmSegment* slf, void* buf, size_t len) {
+	slf->backing_memory = buf;
+	slf->backing_length = len;
+
 	DmRiff rif;
 	if (!DmRiff_init(&rif, buf, len)) {
-		Dm_free(buf);
 		return DmResult_FILE_CORRUPT;
 	}
 
-	slf->backing_memory = buf;
-
 	DmRiff cnk;
 	while (DmRiff_readChunk(&rif, &cnk)) {
 		if (DmRiff_is(&cnk, DM_FOURCC_SEGH, 0)) {
@@ -346,7 +358,7 @@ DmResult DmSegment_parse(DmSegment* slf, void* buf, size_t len) {
 		} else if (DmRiff_is(&cnk, DM_FOURCC_LIST, DM_FOURCC_UNFO)) {
 			DmUnfo_parse(&slf->info, &cnk);
 		} else if (DmRiff_is(&cnk, DM_FOURCC_LIST, DM_FOURCC_TRKL)) {
-			DmSegment_parseTrackList(&slf->messages, &cnk);
+			DmSegment_parseTrackList(&slf->messages, &cnk, &slf->arena);
 		}
 
 		DmRiff_reportDone(&cnk);
@@ -354,3 +366,108 @@ DmResult DmSegment_parse(DmSegment* slf, void* buf, size_t len) {
 
 	return DmResult_SUCCESS;
 }
+
+typedef struct DmSegmentProbe {
+	DmSegmentInfo* info;
+	uint32_t length;
+	uint32_t offset;
+	double tempo;
+	double duration;
+	bool has_tempo;
+} DmSegmentProbe;
+
+// Mirrors DmSegment_parseTempoTrack and DmSegment_getLength without creating any messages.
+static void DmSegment_probeTempoTrack(DmSegmentProbe* slf, DmRiff* rif) {
+	DmTimeSignature signature = {4, 4, 4};
+
+	uint32_t item_size = 0;
+	DmRiff_readDword(rif, &item_size);
+	if (item_size == 0) {
+		return;
+	}
+
+	uint32_t item_count = (rif->len - rif->pos) / item_size;
+	for (uint32_t i = 0; i < item_count; ++i) {
+		uint32_t end_position = rif->pos + item_size;
+
+		uint32_t time = 0;
+		DmRiff_readDword(rif, &time);
+
+		uint32_t pad;
+		DmRiff_readDword(rif, &pad);
+
+		double tempo = 0;
+		DmRiff_readDouble(rif, &tempo);
+
+		if (!slf->has_tempo) {
+			slf->info->tempo = tempo;
+			slf->has_tempo = true;
+		}
+
+		slf->tempo = tempo;
+		slf->duration += (time - slf->offset) / Dm_getTicksPerSecond(signature, tempo);
+		slf->offset = time;
+
+		rif->pos = end_position;
+	}
+}
+
+static void DmSegment_probeTrackList(DmSegmentProbe* slf, DmRiff* rif) {
+	DmRiff trk;
+	while (DmRiff_readChunk(rif, &trk)) {
+		if (DmRiff_is(&trk, DM_FOURCC_RIFF, DM_FOURCC_DMTK)) {
+			DmRiff cnk;
+			while (DmRiff_readChunk(&trk, &cnk)) {
+				if (DmRiff_is(&cnk, DM_FOURCC_TETR, 0)) {
+					DmSegment_probeTempoTrack(slf, &cnk);
+				}
+
+				DmRiff_reportDone(&cnk);
+			}
+		}
+
+		DmRiff_reportDone(&trk);
+	}
+}
+
+// Only the segment header, GUID, name and tempo tracks are read. Since nothing is written to the buffer, it may be
+// read-only or shared with other objects.
+DmResult DmSegment_probe(DmSegmentInfo* slf, void const* buf, size_t len) {
+	DmRiff rif;
+	if (!DmRiff_init(&rif, buf, len)) {
+		return DmResult_FILE_CORRUPT;
+	}
+
+	memset(slf, 0, sizeof *slf);
+	slf->tempo = 100.;
+
+	DmSegmentProbe probe = {0};
+	probe.info = slf;
+	probe.tempo = 100.;
+
+	DmUnfo info = {{0}};
+
+	DmRiff cnk;
+	while (DmRiff_readChunk(&rif, &cnk)) {
+		if (DmRiff_is(&cnk, DM_FOURCC_SEGH, 0)) {
+			DmRiff_readDword(&cnk, &slf->repeats);
+			DmRiff_readDword(&cnk, &probe.length);
+		} else if (DmRiff_is(&cnk, DM_FOURCC_GUID, 0)) {
+			DmGuid_parse(&slf->guid, &cnk);
+		} else if (DmRiff_is(&cnk, DM_FOURCC_LIST, DM_FOURCC_UNFO)) {
+			DmUnfo_parse(&info, &cnk);
+		} else if (DmRiff_is(&cnk, DM_FOURCC_LIST, DM_FOURCC_TRKL)) {
+			DmSegment_probeTrackList(&probe, &cnk);
+		}
+
+		DmRiff_reportDone(&cnk);
+	}
+
+	DmTimeSignature signature = {4, 4, 4};
+	probe.duration += (probe.length - probe.offset) / Dm_getTicksPerSecond(signature, probe.tempo);
+
+	memcpy(slf->name, info.unam, min_usize(sizeof slf->name, sizeof info.unam));
+	slf->name[sizeof slf->name - 1] = '\0';
+	slf->length = probe.duration;
+	return DmResult_SUCCESS;
+}
@@ -23,7 +23,7 @@ static void DmStyle_parsePartReference(DmPartReference* slf, DmRiff* rif) {
 	}
 }
 
-static DmResult DmStyle_parsePattern(DmPattern* slf, DmRiff* rif) {
+static DmResult DmStyle_parsePattern(DmPattern* slf, DmRiff* rif, DmArena* arena) {
 	DmRiff cnk;
 	while (DmRiff_readChunk(rif, &cnk)) {
 		if (DmRiff_is(&cnk, DM_FOURCC_PTNH, 0)) {
@@ -36,7 +36,7 @@ static DmResult DmStyle_parsePattern(DmPattern* slf, DmRiff* rif) {
 			DmUnfo_parse(&slf->info, &cnk);
 		} else if (DmRiff_is(&cnk, DM_FOURCC_RHTM, 0)) {
 			slf->rhythm_len = cnk.len / 4;
-			slf->rhythm = Dm_alloc(cnk.len);
+			slf->rhythm = DmArena_alloc(arena, cnk.len);
 			if (slf->rhythm == NULL) {
 				return DmResult_MEMORY_EXHAUSTED;
 			}
@@ -78,12 +78,12 @@ static uint32_t DmStyle_toCorrectedRange(uint8_t range) {
 	return ((range - 232) * 50) + 500;
 }
 
-static DmResult DmStyle_parsePartNotes(DmPart* part, DmRiff* rif) {
+static DmResult DmStyle_parsePartNotes(DmPart* part, DmRiff* rif, DmArena* arena) {
 	uint32_t item_size = 0;
 	DmRiff_readDword(rif, &item_size);
 
 	part->note_count = (rif->len - rif->pos) / item_size;
-	part->notes = Dm_alloc(part->note_count * sizeof(DmNote));
+	part->notes = DmArena_alloc(arena, part->note_count * sizeof(DmNote));
 
 	if (part->notes == NULL) {
 		return DmResult_MEMORY_EXHAUSTED;
@@ -120,12 +120,12 @@ static DmResult DmStyle_parsePartNotes(DmPart* part, DmRiff* rif) {
 	return DmResult_SUCCESS;
 }
 
-static DmResult DmStyle_parsePartCurves(DmPart* part, DmRiff* rif) {
+static DmResult DmStyle_parsePartCurves(DmPart* part, DmRiff* rif, DmArena* arena) {
 	uint32_t item_size = 0;
 	DmRiff_readDword(rif, &item_size);
 
 	part->curve_count = (rif->len - rif->pos) / item_size;
-	part->curves = Dm_alloc(part->curve_count * sizeof(DmCurve));
+	part->curves = DmArena_alloc(arena, part->curve_count * sizeof(DmCurve));
 
 	if (part->curves == NULL) {
 		return DmResult_MEMORY_EXHAUSTED;
@@ -162,7 +162,17 @@ static DmResult DmStyle_parsePartCurves(DmPart* part, DmRiff* rif) {
 	return DmResult_SUCCESS;
 }
 
-static DmResult DmStyle_parsePart(DmPart* slf, DmRiff* rif) {
+// Without a grid, the offset is relative to the start of the part, so notes with a negative offset are moved to the
+// start instead of wrapping around to the end of time.
+static uint32_t DmStyle_getPartOffset(DmPart* slf, uint32_t grid_start, int16_t time_offset) {
+	if (slf->time_signature.grids_per_beat == 0) {
+		return time_offset < 0 ? 0 : (uint32_t) time_offset;
+	}
+
+	return Dm_getTimeOffset(grid_start, time_offset, slf->time_signature);
+}
+
+static DmResult DmStyle_parsePart(DmPart* slf, DmRiff* rif, DmArena* arena) {
 	DmRiff cnk;
 	while (DmRiff_readChunk(rif, &cnk)) {
 		if (DmRiff_is(&cnk, DM_FOURCC_PRTH, 0)) {
@@ -185,12 +195,12 @@ static DmResult DmStyle_parsePart(DmPart* slf, DmRiff* rif) {
 		} else if (DmRiff_is(&cnk, DM_FOURCC_LIST, DM_FOURCC_UNFO)) {
 			DmUnfo_parse(&slf->info, &cnk);
 		} else if (DmRiff_is(&cnk, DM_FOURCC_NOTE, 0)) {
-			DmResult rv = DmStyle_parsePartNotes(slf, &cnk);
+			DmResult rv = DmStyle_parsePartNotes(slf, &cnk, arena);
 			if (rv != DmResult_SUCCESS) {
 				return rv;
 			}
 		} else if (DmRiff_is(&cnk, DM_FOURCC_CRVE, 0)) {
-			DmResult rv = DmStyle_parsePartCurves(slf, &cnk);
+			DmResult rv = DmStyle_parsePartCurves(slf, &cnk, arena);
 			if (rv != DmResult_SUCCESS) {
 				return rv;
 			}
@@ -199,17 +209,105 @@ static DmResult DmStyle_parsePart(DmPart* slf, DmRiff* rif) {
 		DmRiff_reportDone(&cnk);
 	}
 
+	// Resolve the timing and play mode of all notes and curves up-front since they only depend on the part header.
+	for (uint32_t i = 0; i < slf->note_count; ++i) {
+		DmNote* note = &slf->notes[i];
+		note->offset = DmStyle_getPartOffset(slf, note->grid_start, note->time_offset);
+
+		if (note->play_mode_flags == DmPlayMode_NONE) {
+			note->play_mode_flags = slf->play_mode_flags;
+		}
+	}
+
+	for (uint32_t i = 0; i < slf->curve_count; ++i) {
+		DmCurve* curve = &slf->curves[i];
+		curve->offset = DmStyle_getPartOffset(slf, curve->grid_start, curve->time_offset);
+	}
+
+	// Order notes and curves by their offset so that they can be played back one measure at a time. They are usually
+	// stored in order already, so an insertion sort is used. It also keeps the order of simultaneous events.
+	for (uint32_t i = 1; i < slf->note_count; ++i) {
+		DmNote note = slf->notes[i];
+
+		uint32_t j = i;
+		for (; j > 0 && slf->notes[j - 1].offset > note.offset; --j) {
+			slf->notes[j] = slf->notes[j - 1];
+		}
+
+		slf->notes[j] = note;
+	}
+
+	for (uint32_t i = 1; i < slf->curve_count; ++i) {
+		DmCurve curve = slf->curves[i];
+
+		uint32_t j = i;
+		for (; j > 0 && slf->curves[j - 1].offset > curve.offset; --j) {
+			slf->curves[j] = slf->curves[j - 1];
+		}
+
+		slf->curves[j] = curve;
+	}
+
 	return DmResult_SUCCESS;
 }
 
+// Measures the arena memory needed for the items of a note or curve chunk. Chunks with an invalid item size are
+// reported once they are parsed.
+static size_t DmStyle_measureItems(DmRiff const* rif, size_t size) {
+	uint32_t item_size = 0;
+	if (rif->len < sizeof item_size) {
+		return 0;
+	}
+
+	memcpy(&item_size, rif->mem, sizeof item_size);
+	if (item_size == 0) {
+		return 0;
+	}
+
+	return DmArena_measure((rif->len - sizeof item_size) / item_size * size);
+}
+
+// Measures the arena memory needed to parse a style. Mirrors the allocations made while parsing, so that all of them
+// fit into the arena for well-formed files.
+static size_t DmStyle_measure(DmRiff rif) {
+	size_t size = 0;
+
+	DmRiff cnk;
+	while (DmRiff_readChunk(&rif, &cnk)) {
+		DmRiff itm;
+		if (DmRiff_is(&cnk, DM_FOURCC_LIST, DM_FOURCC_PART)) {
+			while (DmRiff_readChunk(&cnk, &itm)) {
+				if (DmRiff_is(&itm, DM_FOURCC_NOTE, 0)) {
+					size += DmStyle_measureItems(&itm, sizeof(DmNote));
+				} else if (DmRiff_is(&itm, DM_FOURCC_CRVE, 0)) {
+					size += DmStyle_measureItems(&itm, sizeof(DmCurve));
+				}
+			}
+		} else if (DmRiff_is(&cnk, DM_FOURCC_LIST, DM_FOURCC_PTTN)) {
+			while (DmRiff_readChunk(&cnk, &itm)) {
+				if (DmRiff_is(&itm, DM_FOURCC_RHTM, 0)) {
+					size += DmArena_measure(itm.len);
+				}
+			}
+		}
+	}
+
+	return size;
+}
+
 DmResult DmStyle_parse(DmStyle* slf, void* buf, size_t len) {
+	slf->backing_memory = buf;
+	slf->backing_length = len;
+
 	DmRiff rif;
 	if (!DmRiff_init(&rif, buf, len)) {
-		Dm_free(buf);
 		return DmResult_FILE_CORRUPT;
 	}
 
-	slf->backing_memory = buf;
+	// The notes and curves of all parts and the rhythms of all patterns are allocated from a single arena.
+	if (DmArena_init(&slf->arena, DmStyle_measure(rif)) != DmResult_SUCCESS) {
+		return DmResult_MEMORY_EXHAUSTED;
+	}
 
 	DmRiff cnk;
 	while (DmRiff_readChunk(&rif, &cnk)) {
@@ -244,9 +342,8 @@ DmResult DmStyle_parse(DmStyle* slf, void* buf, size_t len) {
 			DmPart part;
 			DmPart_init(&part);
 
-			DmResult rv = DmStyle_parsePart(&part, &cnk);
+			DmResult rv = DmStyle_parsePart(&part, &cnk, &slf->arena);
 			if (rv != DmResult_SUCCESS) {
-				DmPart_free(&part);
 				return rv;
 			}
 
@@ -258,7 +355,7 @@ DmResult DmStyle_parse(DmStyle* slf, void* buf, size_t len) {
 			DmPattern pttn;
 			DmPattern_init(&pttn);
 
-			DmResult rv = DmStyle_parsePattern(&pttn, &cnk);
+			DmResult rv = DmStyle_parsePattern(&pttn, &cnk, &slf->arena);
 			if (rv != DmResult_SUCCESS) {
 				DmPattern_free(&pttn);
 				return rv;
@@ -0,0 +1,35 @@
+// Copyright © 2024. GothicKit Contributors
+// SPDX-License-Identifier: MIT-Modern-Variant
+#pragma once
+#include "dmusic.h"
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// \brief A separately allocated block used once an arena's memory is used up.
+typedef struct DmArenaBlock {
+	struct DmArenaBlock* next;
+} DmArenaBlock;
+
+/// \brief A bump allocator owning all memory allocated from it, which is freed at once.
+///
+/// An arena is sized up front, usually by measuring the file an object is parsed from. Allocations which don't fit
+/// fall back to separate heap allocations, so a size which is too small only costs performance. Allocating from an
+/// arena is thread-safe; freeing it is not.
+typedef struct DmArena {
+	uint8_t* data;
+	size_t capacity;
+	_Atomic size_t used;
+	_Atomic(DmArenaBlock*) overflow;
+} DmArena;
+
+DMINT DmResult DmArena_init(DmArena* slf, size_t capacity);
+DMINT void DmArena_free(DmArena* slf);
+DMINT void* DmArena_alloc(DmArena* slf, size_t len);
+
+/// \brief Get the number of bytes an arena needs to hold an allocation of \p len bytes.
+DMINT size_t DmArena_measure(size_t len);
+
+/// \brief Get the number of bytes of memory held by an arena, not counting the headers of overflow allocations.
+DMINT size_t DmArena_getSize(DmArena* slf);
@@ -15,6 +15,8 @@
                                                                                                                        \
 	DMINT void Name##_init(Name* slf);                                                                                 \
 	DMINT void Name##_free(Name* slf);                                                                                 \
+	DMINT DmResult Name##_reserve(Name* slf, size_t capacity);                                                         \
+	DMINT void Name##_shrink(Name* slf);                                                                               \
 	DMINT DmResult Name##_add(Name* slf, Type val);                                                                    \
 	DMINT Type Name##_get(Name const* slf, size_t i)
 
@@ -46,25 +48,55 @@
 		slf->capacity = 0;                                                                                             \
 	}                                                                                                                  \
                                                                                                                        \
-	DmResult Name##_add(Name* slf, Type val) {                                                                         \
+	DmResult Name##_reserve(Name* slf, size_t capacity) {                                                              \
 		if (slf == NULL) {                                                                                             \
 			return DmResult_INVALID_ARGUMENT;                                                                          \
 		}                                                                                                              \
                                                                                                                        \
-		if (slf->data == NULL || slf->length + 1 > slf->capacity) {                                                    \
-			size_t newSize = slf->capacity == 0 ? 10 : slf->capacity * 2;                                              \
-			Type* newData = Dm_alloc(sizeof(Type) * newSize);                                                          \
-			if (newData == NULL) {                                                                                     \
-				return DmResult_MEMORY_EXHAUSTED;                                                                      \
-			}                                                                                                          \
+		if (capacity <= slf->capacity) {                                                                               \
+			return DmResult_SUCCESS;                                                                                   \
+		}                                                                                                              \
                                                                                                                        \
-			if (slf->data != NULL) {                                                                                   \
-				memcpy(newData, slf->data, slf->length * sizeof(Type));                                                \
-			}                                                                                                          \
+		Type* newData = Dm_realloc(slf->data, sizeof(Type) * slf->capacity, sizeof(Type) * capacity);                  \
+		if (newData == NULL) {                                                                                         \
+			return DmResult_MEMORY_EXHAUSTED;                                                                          \
+		}                                                                                                              \
+                                                                                                                       \
+		slf->data = newData;                                                                                           \
+		slf->capacity = capacity;                                                                                      \
+		return DmResult_SUCCESS;                                                                                       \
+	}                                                                                                                  \
+                                                                                                                       \
+	void Name##_shrink(Name* slf) {                                                                                    \
+		if (slf == NULL || slf->length == slf->capacity) {                                                             \
+			return;                                                                                                    \
+		}                                                                                                              \
                                                                                                                        \
+		if (slf->length == 0) {                                                                                        \
 			Dm_free(slf->data);                                                                                        \
+			slf->data = NULL;                                                                                          \
+			slf->capacity = 0;                                                                                         \
+			return;                                                                                                    \
+		}                                                                                                              \
+                                                                                                                       \
+		/* If shrinking fails, the array simply keeps its larger buffer. */                                            \
+		Type* newData = Dm_realloc(slf->data, sizeof(Type) * slf->capacity, sizeof(Type) * slf->length);               \
+		if (newData != NULL) {                                                                                         \
 			slf->data = newData;                                                                                       \
-			slf->capacity = newSize;                                                                                   \
+			slf->capacity = slf->length;                                                                               \
+		}                                                                                                              \
+	}                                                                                                                  \
+                                                                                                                       \
+	DmResult Name##_add(Name* slf, Type val) {                                                                         \
+		if (slf == NULL) {                                                                                             \
+			return DmResult_INVALID_ARGUMENT;                                                                          \
+		}                                                                                                              \
+                                                                                                                       \
+		if (slf->length + 1 > slf->capacity) {                                                                         \
+			DmResult rv = Name##_reserve(slf, slf->capacity == 0 ? 10 : slf->capacity * 2);                            \
+			if (rv != DmResult_SUCCESS) {                                                                              \
+				return rv;                                                                                             \
+			}                                                                                                          \
 		}                                                                                                              \
                                                                                                                        \
 		slf->data[slf->length++] = val;                                                                                \
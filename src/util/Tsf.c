@@ -59,6 +59,14 @@ enum {
 	kLinear = 0,
 };
 
+enum {
+	DmInt_DECODE_GRAIN = 8,
+
+	// Key range, velocity range, exclusive class, root key, fine tune, attenuation, four loop offsets, sample modes
+	// and sample ID.
+	DmInt_REGION_MAX_FIXED_GENERATORS = 12,
+};
+
 static void DmSynth_insertGenerators(SFGeneratorList* gens, DmDlsArticulator* art) {
 	for (size_t k = 0; k < art->connection_count; ++k) {
 		struct DmDlsArticulatorConnection* con = &art->connections[k];
@@ -319,6 +327,23 @@ static void DmSynth_insertModulators(SFModulatorList* mods, DmDlsArticulator* ar
 	}
 }
 
+typedef struct DmHydraSamples {
+	DmDls* dls;
+	float* samples;
+	struct tsf_hydra_shdr const* headers;
+} DmHydraSamples;
+
+// The sample buffer is not zeroed when it is allocated, so everything not written by the decoder is cleared here.
+static void Dm_decodeHydraSamples(void* ctx, size_t begin, size_t end) {
+	DmHydraSamples* slf = ctx;
+	for (size_t i = begin; i < end; ++i) {
+		struct tsf_hydra_shdr const* hdr = &slf->headers[i];
+		size_t len = hdr->end - hdr->start;
+		size_t written = DmDls_decodeSamples(&slf->dls->wave_table[i], slf->samples + hdr->start, len);
+		memset(slf->samples + hdr->start + written, 0, sizeof(float) * (len - written + kSamplePadding));
+	}
+}
+
 static DmResult
 Dm_createHydraSamplesForDls(DmDls* dls, float** pcm, int32_t* pcm_len, struct tsf_hydra_shdr** cfg, int32_t* cfg_len) {
 	// 1. Count the number of PCM samples actually required after decoding.
@@ -338,9 +363,30 @@ Dm_createHydraSamplesForDls(DmDls* dls, float** pcm, int32_t* pcm_len, struct ts
 		return DmResult_MEMORY_EXHAUSTED;
 	}
 
-	float* samples = Dm_alloc(sizeof(float) * sample_count);
-	if (samples == NULL) {
-		return DmResult_MEMORY_EXHAUSTED;
+	// When streaming, the samples are decoded by DmDls_decodePreset once they are needed. Until then, the reserved
+	// memory is not committed.
+	float* samples = NULL;
+	if (dls->stream) {
+		samples = Dm_reserveMemory(sizeof(float) * sample_count);
+		dls->wave_offsets = Dm_alloc(sizeof(uint32_t) * (dls->wave_table_size + 1));
+		dls->wave_decoded = Dm_alloc(sizeof(bool) * (dls->wave_table_size + 1));
+
+		if (samples == NULL || dls->wave_offsets == NULL || dls->wave_decoded == NULL) {
+			Dm_releaseMemory(samples, sizeof(float) * sample_count);
+			Dm_free(dls->wave_offsets);
+			Dm_free(dls->wave_decoded);
+			dls->wave_offsets = NULL;
+			dls->wave_decoded = NULL;
+			return DmResult_MEMORY_EXHAUSTED;
+		}
+
+		dls->font_samples = samples;
+		dls->font_samples_length = sizeof(float) * sample_count;
+	} else {
+		samples = Dm_allocUninit(sizeof(float) * sample_count);
+		if (samples == NULL) {
+			return DmResult_MEMORY_EXHAUSTED;
+		}
 	}
 
 	size_t sample_offset = 0;
@@ -354,7 +400,12 @@ Dm_createHydraSamplesForDls(DmDls* dls, float** pcm, int32_t* pcm_len, struct ts
 		sample_headers[i].endLoop = (uint32_t) sample_offset;
 		sample_headers[i].sampleRate = wav->samples_per_second;
 		sample_headers[i].sampleType = 1; // SFSampleLink::monoSample
-		sample_offset += DmDls_decodeSamples(wav, samples + sample_offset, sample_count - sample_offset);
+
+		if (dls->stream) {
+			dls->wave_offsets[i] = (uint32_t) sample_offset;
+		}
+
+		sample_offset += DmDls_decodeSamples(wav, NULL, 0);
 		sample_headers[i].end = (uint32_t) sample_offset;
 
 		// There are 46 0-samples after each "real" sample
@@ -363,6 +414,14 @@ Dm_createHydraSamplesForDls(DmDls* dls, float** pcm, int32_t* pcm_len, struct ts
 
 	strncpy(sample_headers[sample_headers_length - 1].sampleName, "EOS", 19);
 
+	if (dls->stream) {
+		dls->wave_offsets[dls->wave_table_size] = (uint32_t) sample_offset;
+	} else {
+		// Every wave is decoded into the slot reserved for it above, so they can be decoded in parallel.
+		DmHydraSamples hs = {dls, samples, sample_headers};
+		Dm_runParallel(dls->wave_table_size, DmInt_DECODE_GRAIN, Dm_decodeHydraSamples, &hs);
+	}
+
 	*pcm = samples;
 	*pcm_len = sample_count;
 	*cfg = sample_headers;
@@ -408,15 +467,42 @@ static DmResult Dm_createHydraSkeleton(DmDls* dls, struct tsf_hydra* res) {
 
 	res->ibags = Dm_alloc(sizeof(struct tsf_hydra_ibag) * res->ibagNum);
 
-	// 7. Calculate the number of sample headers required and allocate them
-	res->shdrNum = dls->wave_table_size + 1; // One for the sentinel
-	res->shdrs = Dm_alloc(sizeof(struct tsf_hydra_shdr) * res->shdrNum);
+	// 7. The sample headers are allocated along with the samples themselves by Dm_createHydraSamplesForDls.
+	res->shdrNum = 0;
+	res->shdrs = NULL;
 
-	bool ok =
-	    res->phdrs && res->pbags && res->pgens && res->pmods && res->insts && res->ibags && res->shdrNum;
+	bool ok = res->phdrs && res->pbags && res->pgens && res->pmods && res->insts && res->ibags;
 	return ok ? DmResult_SUCCESS : DmResult_MEMORY_EXHAUSTED;
 }
 
+// Each region produces at most one generator per articulator connection on top of its fixed generators, and at most
+// one modulator per connection. Reserving this upper bound means the generator and modulator lists never grow.
+static void DmSynth_countHydraZones(DmDls const* dls, size_t* gen_count, size_t* mod_count) {
+	size_t gens = 1; // One for the sentinel
+	size_t mods = 1; // One for the sentinel
+
+	for (size_t i = 0; i < dls->instrument_count; ++i) {
+		DmDlsInstrument const* ins = &dls->instruments[i];
+
+		for (size_t r = 0; r < ins->region_count; ++r) {
+			DmDlsRegion const* reg = &ins->regions[r];
+			DmDlsArticulator const* arts = reg->articulator_count == 0 ? ins->articulators : reg->articulators;
+			size_t art_count = reg->articulator_count == 0 ? ins->articulator_count : reg->articulator_count;
+
+			size_t connections = 0;
+			for (size_t a = 0; a < art_count; ++a) {
+				connections += arts[a].connection_count;
+			}
+
+			gens += DmInt_REGION_MAX_FIXED_GENERATORS + connections;
+			mods += connections;
+		}
+	}
+
+	*gen_count = gens;
+	*mod_count = mods;
+}
+
 // We export this function for the tools.
 static DmResult Dm_createHydra(DmDls* dls, struct tsf_hydra* hydra, float** pcm, int32_t* pcm_len) {
 	DmResult rv = Dm_createHydraSkeleton(dls, hydra);
@@ -440,6 +526,17 @@ static DmResult Dm_createHydra(DmDls* dls, struct tsf_hydra* hydra, float** pcm,
 	SFGeneratorList igen;
 	SFGeneratorList_init(&igen);
 
+	size_t igen_count = 0;
+	size_t imod_count = 0;
+	DmSynth_countHydraZones(dls, &igen_count, &imod_count);
+
+	if (SFGeneratorList_reserve(&igen, igen_count) != DmResult_SUCCESS ||
+	    SFModulatorList_reserve(&imod, imod_count) != DmResult_SUCCESS) {
+		SFGeneratorList_free(&igen);
+		SFModulatorList_free(&imod);
+		return DmResult_MEMORY_EXHAUSTED;
+	}
+
 	// Fill the hydra with useful data
 	uint32_t pgen_ndx = 0;
 	uint32_t pmod_ndx = 0;
@@ -580,6 +677,11 @@ static DmResult Dm_createHydra(DmDls* dls, struct tsf_hydra* hydra, float** pcm,
 	mod.modTransOper = 0;
 	SFModulatorList_add(&imod, mod);
 
+	// Scaled controlled source connections and unknown destinations don't produce anything, so the upper bound might
+	// not have been reached.
+	SFGeneratorList_shrink(&igen);
+	SFModulatorList_shrink(&imod);
+
 	// Populate the sentinel values of the hydra
 	strncpy(hydra->phdrs[hydra->phdrNum - 1].presetName, "EOP", 19);
 	hydra->phdrs[hydra->phdrNum - 1].bank = 0;
@@ -632,7 +734,7 @@ static void Dm_freeHydra(struct tsf_hydra* hydra) {
 	Dm_free(hydra->shdrs);
 }
 
-DmResult DmSynth_createTsfForDls(DmDls* dls, tsf** out) {
+DmResult DmSynth_createTsfForDls(DmDls* dls, tsf** out, size_t* sample_count) {
 	if (dls == NULL) {
 		return DmResult_INVALID_ARGUMENT;
 	}
@@ -660,8 +762,141 @@ DmResult DmSynth_createTsfForDls(DmDls* dls, tsf** out) {
 
 	res->fontSamples = pcm;
 
+	if (sample_count != NULL) {
+		*sample_count = (size_t) pcm_len;
+	}
+
 	// Lastly, free up all the hydra stuff
 	Dm_freeHydra(&hydra);
 
 	return DmResult_SUCCESS;
 }
+
+// Must be called with the font lock held.
+static void DmDls_addFontSize(DmDls* slf, size_t size) {
+	slf->font_size += size;
+	if (slf->font_memory != NULL) {
+		(void) atomic_fetch_add(slf->font_memory, size);
+	}
+}
+
+void DmDls_detachFontMemory(DmDls* slf) {
+	if (slf == NULL || mtx_lock(&slf->font_lock) != thrd_success) {
+		return;
+	}
+
+	if (slf->font_memory != NULL) {
+		(void) atomic_fetch_sub(slf->font_memory, slf->font_size);
+		slf->font_memory = NULL;
+	}
+
+	(void) mtx_unlock(&slf->font_lock);
+}
+
+// Building a font decodes every sample in the collection, so it is only done once per collection. Every synthesizer
+// then gets its own copy with separate voices and channels, which shares the presets and samples with the original.
+DmResult DmDls_getFont(DmDls* slf, tsf** out) {
+	if (slf == NULL) {
+		return DmResult_INVALID_ARGUMENT;
+	}
+
+	if (mtx_lock(&slf->font_lock) != thrd_success) {
+		return DmResult_MUTEX_ERROR;
+	}
+
+	DmResult rv = DmResult_SUCCESS;
+	if (slf->font == NULL) {
+		uint64_t start = Dm_getMonotonicTime();
+
+		if (DmDls_loadFontCache(slf, &slf->font)) {
+			DmDls_addFontSize(slf, slf->font_mapping_length);
+		} else {
+			size_t sample_count = 0;
+			rv = DmSynth_createTsfForDls(slf, &slf->font, &sample_count);
+			if (rv != DmResult_SUCCESS) {
+				tsf_close(slf->font);
+				slf->font = NULL;
+			} else if (!slf->stream) {
+				// Streamed fonts are missing the samples of waves which have not been played yet.
+				DmDls_saveFontCache(slf, slf->font, sample_count);
+				DmDls_addFontSize(slf, sample_count * sizeof(float));
+			}
+		}
+
+		(void) atomic_fetch_add(&slf->font_time, Dm_getMonotonicTime() - start);
+	}
+
+	if (rv == DmResult_SUCCESS && out != NULL) {
+		*out = tsf_copy(slf->font);
+		if (*out == NULL) {
+			rv = DmResult_MEMORY_EXHAUSTED;
+		}
+	}
+
+	(void) mtx_unlock(&slf->font_lock);
+	return rv;
+}
+
+void DmDls_closeFont(DmDls* slf, tsf* fnt) {
+	if (slf == NULL || fnt == NULL) {
+		return;
+	}
+
+	if (mtx_lock(&slf->font_lock) != thrd_success) {
+		return;
+	}
+
+	tsf_close(fnt);
+	(void) mtx_unlock(&slf->font_lock);
+}
+
+// Finds the wave whose samples start at or before the given offset into the font's samples.
+static uint32_t DmDls_findWave(DmDls const* slf, uint32_t offset) {
+	uint32_t low = 0;
+	uint32_t high = slf->wave_table_size;
+
+	while (high - low > 1) {
+		uint32_t mid = low + (high - low) / 2;
+		if (slf->wave_offsets[mid] <= offset) {
+			low = mid;
+		} else {
+			high = mid;
+		}
+	}
+
+	return low;
+}
+
+// The slot of each wave, including its padding, is only committed once the wave is decoded.
+DmResult DmDls_decodePreset(DmDls* slf, tsf const* fnt, int preset) {
+	if (slf == NULL || fnt == NULL || slf->wave_offsets == NULL || preset < 0 || preset >= fnt->presetNum) {
+		return DmResult_SUCCESS;
+	}
+
+	if (mtx_lock(&slf->font_lock) != thrd_success) {
+		return DmResult_MUTEX_ERROR;
+	}
+
+	DmResult rv = DmResult_SUCCESS;
+	struct tsf_preset const* pre = &fnt->presets[preset];
+	for (int i = 0; i < pre->regionNum; ++i) {
+		uint32_t wave = DmDls_findWave(slf, pre->regions[i].offset);
+		if (wave >= slf->wave_table_size || slf->wave_decoded[wave]) {
+			continue;
+		}
+
+		uint32_t offset = slf->wave_offsets[wave];
+		uint32_t length = slf->wave_offsets[wave + 1] - offset - kSamplePadding;
+		if (!Dm_commitMemory(slf->font_samples + offset, (length + kSamplePadding) * sizeof(float))) {
+			rv = DmResult_MEMORY_EXHAUSTED;
+			break;
+		}
+
+		(void) DmDls_decodeSamples(&slf->wave_table[wave], slf->font_samples + offset, length);
+		slf->wave_decoded[wave] = true;
+		DmDls_addFontSize(slf, length * sizeof(float));
+	}
+
+	(void) mtx_unlock(&slf->font_lock);
+	return rv;
+}
@@ -0,0 +1,266 @@
+// Copyright © 2024. GothicKit Contributors
+// SPDX-License-Identifier: MIT-Modern-Variant
+#include "_Internal.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <tsf.h>
+
+// Precompiled fonts are stored in files with the following layout, using the byte order of the machine
+// which created them:
+//
+//   DmFontCacheHeader
+//   DmFontCachePreset[preset_count]
+//   struct tsf_region[region_count]   (the regions of each preset, in preset order)
+//   padding up to sample_offset
+//   float[sample_count]               (the decoded samples, used in-place from the memory mapping)
+//
+// The cache is only valid for the exact DLS collection it was built from and for this version of the conversion,
+// so it is checked against the collection's GUID, version and size as well as the format number below.
+
+enum {
+	DmInt_FONT_CACHE_FORMAT = 1,
+	DmInt_FONT_CACHE_BYTE_ORDER = 0x01020304,
+	DmInt_FONT_CACHE_ALIGNMENT = 16,
+	DmInt_FONT_CACHE_TEMPORARY_ATTEMPTS = 16,
+};
+
+static char const DmInt_FONT_CACHE_MAGIC[8] = "DMFONT\0";
+
+typedef struct DmFontCacheHeader {
+	char magic[8];
+	uint32_t format;
+	uint32_t byte_order;
+	uint32_t region_size;
+	uint32_t preset_count;
+	uint32_t region_count;
+	uint32_t sample_count;
+	uint64_t sample_offset;
+	uint64_t source_length;
+	DmGuid guid;
+	DmVersion version;
+} DmFontCacheHeader;
+
+typedef struct DmFontCachePreset {
+	char name[20];
+	uint16_t preset;
+	uint16_t bank;
+	uint32_t region_count;
+} DmFontCachePreset;
+
+static bool DmFontCache_isValid(DmDls* dls, uint8_t const* buf, size_t len) {
+	if (len < sizeof(DmFontCacheHeader)) {
+		return false;
+	}
+
+	DmFontCacheHeader hdr;
+	memcpy(&hdr, buf, sizeof hdr);
+
+	if (memcmp(hdr.magic, DmInt_FONT_CACHE_MAGIC, sizeof hdr.magic) != 0 || hdr.format != DmInt_FONT_CACHE_FORMAT ||
+	    hdr.byte_order != DmInt_FONT_CACHE_BYTE_ORDER || hdr.region_size != sizeof(struct tsf_region)) {
+		return false;
+	}
+
+	if (!DmGuid_equals(&hdr.guid, &dls->guid) || hdr.version.ms != dls->version.ms ||
+	    hdr.version.ls != dls->version.ls || hdr.source_length != dls->backing_length) {
+		return false;
+	}
+
+	uint64_t tables_end = sizeof hdr + (uint64_t) hdr.preset_count * sizeof(DmFontCachePreset) +
+	    (uint64_t) hdr.region_count * sizeof(struct tsf_region);
+	uint64_t samples_end = hdr.sample_offset + (uint64_t) hdr.sample_count * sizeof(float);
+
+	return hdr.sample_offset % sizeof(float) == 0 && hdr.sample_offset >= tables_end && samples_end <= len;
+}
+
+// TinySoundFont releases fonts using `free`, so everything owned by the font is allocated using `malloc` here.
+bool DmDls_loadFontCache(DmDls* slf, tsf** out) {
+	if (slf->font_cache_path == NULL) {
+		return false;
+	}
+
+	size_t len = 0;
+	uint8_t* buf = Dm_mapFile(slf->font_cache_path, &len);
+	if (buf == NULL) {
+		return false;
+	}
+
+	if (!DmFontCache_isValid(slf, buf, len)) {
+		Dm_report(DmLogLevel_INFO, "DmDls: Font cache '%s' is stale", slf->font_cache_path);
+		Dm_unmapFile(NULL, buf, len);
+		return false;
+	}
+
+	DmFontCacheHeader hdr;
+	memcpy(&hdr, buf, sizeof hdr);
+
+	tsf* fnt = calloc(1, sizeof *fnt);
+	struct tsf_preset* presets = calloc(hdr.preset_count + 1, sizeof *presets);
+	if (fnt == NULL || presets == NULL) {
+		free(fnt);
+		free(presets);
+		Dm_unmapFile(NULL, buf, len);
+		return false;
+	}
+
+	fnt->presets = presets;
+	fnt->presetNum = (int) hdr.preset_count;
+
+	uint8_t const* preset_data = buf + sizeof hdr;
+	uint8_t const* region_data = preset_data + hdr.preset_count * sizeof(DmFontCachePreset);
+	uint32_t regions_left = hdr.region_count;
+	bool ok = true;
+
+	for (uint32_t i = 0; i < hdr.preset_count && ok; ++i) {
+		DmFontCachePreset rec;
+		memcpy(&rec, preset_data + i * sizeof rec, sizeof rec);
+
+		struct tsf_preset* preset = &presets[i];
+		memcpy(preset->presetName, rec.name, sizeof preset->presetName);
+		preset->presetName[sizeof preset->presetName - 1] = '\0';
+		preset->preset = rec.preset;
+		preset->bank = rec.bank;
+		preset->regionNum = (int) rec.region_count;
+
+		if (rec.region_count > regions_left) {
+			ok = false;
+			break;
+		}
+
+		preset->regions = malloc(rec.region_count * sizeof *preset->regions + 1);
+		if (preset->regions == NULL) {
+			ok = false;
+			break;
+		}
+
+		memcpy(preset->regions, region_data, rec.region_count * sizeof *preset->regions);
+		region_data += rec.region_count * sizeof *preset->regions;
+		regions_left -= rec.region_count;
+
+		// Make sure a corrupted cache can't cause the synthesizer to read past the end of the samples.
+		for (uint32_t r = 0; r < rec.region_count; ++r) {
+			struct tsf_region const* region = &preset->regions[r];
+			if (region->end > hdr.sample_count || region->loop_end > hdr.sample_count) {
+				ok = false;
+			}
+		}
+	}
+
+	if (!ok) {
+		Dm_report(DmLogLevel_WARN, "DmDls: Font cache '%s' is corrupt", slf->font_cache_path);
+		tsf_close(fnt);
+		Dm_unmapFile(NULL, buf, len);
+		return false;
+	}
+
+	fnt->fontSamples = (float*) (buf + hdr.sample_offset);
+	slf->font_mapping = buf;
+	slf->font_mapping_length = len;
+
+	Dm_report(DmLogLevel_DEBUG, "DmDls: Loaded font from cache '%s'", slf->font_cache_path);
+	*out = fnt;
+	return true;
+}
+
+static bool DmFontCache_write(FILE* fp, void const* data, size_t len) {
+	return len == 0 || fwrite(data, 1, len, fp) == len;
+}
+
+// The cache directory may be shared by multiple loaders and processes building the same font at the same time, so
+// each writer creates its own temporary file. Creating it exclusively guarantees that no two writers ever share one,
+// even if their generated names collide.
+static FILE* DmFontCache_createTemporary(char const* path, char* tmp_path, size_t tmp_len) {
+	static _Atomic uint64_t counter = 0;
+
+	for (int i = 0; i < DmInt_FONT_CACHE_TEMPORARY_ATTEMPTS; ++i) {
+		uint64_t id = Dm_getMonotonicTime() ^ (uint64_t) (uintptr_t) tmp_path ^ (atomic_fetch_add(&counter, 1) << 48);
+		(void) snprintf(tmp_path, tmp_len, "%s.%016llx.tmp", path, (unsigned long long) id);
+
+		FILE* fp = fopen(tmp_path, "wbx");
+		if (fp != NULL || errno != EEXIST) {
+			return fp;
+		}
+	}
+
+	return NULL;
+}
+
+// The cache is written to a temporary file first and moved into place afterward, so that other processes never
+// observe a partially written cache file.
+void DmDls_saveFontCache(DmDls* slf, tsf const* fnt, size_t sample_count) {
+	if (slf->font_cache_path == NULL || fnt == NULL || sample_count > UINT32_MAX) {
+		return;
+	}
+
+	DmFontCacheHeader hdr;
+	memset(&hdr, 0, sizeof hdr);
+	memcpy(hdr.magic, DmInt_FONT_CACHE_MAGIC, sizeof hdr.magic);
+	hdr.format = DmInt_FONT_CACHE_FORMAT;
+	hdr.byte_order = DmInt_FONT_CACHE_BYTE_ORDER;
+	hdr.region_size = sizeof(struct tsf_region);
+	hdr.preset_count = (uint32_t) fnt->presetNum;
+	hdr.sample_count = (uint32_t) sample_count;
+	hdr.source_length = slf->backing_length;
+	hdr.guid = slf->guid;
+	hdr.version = slf->version;
+
+	for (int i = 0; i < fnt->presetNum; ++i) {
+		hdr.region_count += (uint32_t) fnt->presets[i].regionNum;
+	}
+
+	uint64_t tables_end = sizeof hdr + (uint64_t) hdr.preset_count * sizeof(DmFontCachePreset) +
+	    (uint64_t) hdr.region_count * sizeof(struct tsf_region);
+	hdr.sample_offset = (tables_end + DmInt_FONT_CACHE_ALIGNMENT - 1) / DmInt_FONT_CACHE_ALIGNMENT *
+	    DmInt_FONT_CACHE_ALIGNMENT;
+
+	// The temporary file name is the cache file's name followed by a dot, 16 hex digits and ".tmp".
+	size_t tmp_len = strlen(slf->font_cache_path) + 22;
+	char* tmp_path = Dm_alloc(tmp_len);
+	if (tmp_path == NULL) {
+		return;
+	}
+
+	FILE* fp = DmFontCache_createTemporary(slf->font_cache_path, tmp_path, tmp_len);
+	if (fp == NULL) {
+		Dm_report(DmLogLevel_WARN, "DmDls: Failed to create font cache '%s'", tmp_path);
+		Dm_free(tmp_path);
+		return;
+	}
+
+	bool ok = DmFontCache_write(fp, &hdr, sizeof hdr);
+	for (int i = 0; i < fnt->presetNum && ok; ++i) {
+		DmFontCachePreset rec;
+		memset(&rec, 0, sizeof rec);
+		memcpy(rec.name, fnt->presets[i].presetName, sizeof rec.name);
+		rec.preset = fnt->presets[i].preset;
+		rec.bank = fnt->presets[i].bank;
+		rec.region_count = (uint32_t) fnt->presets[i].regionNum;
+		ok = DmFontCache_write(fp, &rec, sizeof rec);
+	}
+
+	for (int i = 0; i < fnt->presetNum && ok; ++i) {
+		struct tsf_preset const* preset = &fnt->presets[i];
+		ok = DmFontCache_write(fp, preset->regions, (size_t) preset->regionNum * sizeof *preset->regions);
+	}
+
+	static uint8_t const padding[DmInt_FONT_CACHE_ALIGNMENT] = {0};
+	ok = ok && DmFontCache_write(fp, padding, (size_t) (hdr.sample_offset - tables_end));
+	ok = ok && DmFontCache_write(fp, fnt->fontSamples, sample_count * sizeof(float));
+	ok = fclose(fp) == 0 && ok;
+
+	// `rename` does not replace existing files on all platforms, in which case the existing file is removed first.
+	if (ok && rename(tmp_path, slf->font_cache_path) != 0) {
+		(void) remove(slf->font_cache_path);
+		ok = rename(tmp_path, slf->font_cache_path) == 0;
+	}
+
+	if (!ok) {
+		Dm_report(DmLogLevel_WARN, "DmDls: Failed to write font cache '%s'", slf->font_cache_path);
+		(void) remove(tmp_path);
+	} else {
+		Dm_report(DmLogLevel_DEBUG, "DmDls: Wrote font cache '%s'", slf->font_cache_path);
+	}
+
+	Dm_free(tmp_path);
+}
@@ -0,0 +1,114 @@
+// Copyright © 2024. GothicKit Contributors
+// SPDX-License-Identifier: MIT-Modern-Variant
+#include "_Internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+enum {
+	DmInt_BENCH_DEFAULT_MIB = 16,
+	DmInt_BENCH_RUNS = 10,
+	DmInt_BENCH_ADPCM_BLOCK_ALIGN = 2048,
+};
+
+static int16_t const DmBench_ADPCM_COEFF1[7] = {256, 512, 0, 192, 240, 460, 392};
+static int16_t const DmBench_ADPCM_COEFF2[7] = {0, -256, 0, 64, 0, -208, -232};
+
+// The decoders don't depend on the sample values, so the input is filled with reproducible noise.
+static void DmBench_fill(uint8_t* buf, size_t len) {
+	uint32_t state = 0x12345678;
+	for (size_t i = 0; i < len; ++i) {
+		state = state * 1664525 + 1013904223;
+		buf[i] = (uint8_t) (state >> 24);
+	}
+}
+
+static void DmBench_run(char const* name, DmDlsWave const* wav) {
+	size_t sample_count = DmDls_decodeSamples(wav, NULL, 0);
+	float* samples = malloc(sample_count * sizeof *samples);
+	if (samples == NULL) {
+		fputs("Allocating the output buffer failed\n", stderr);
+		return;
+	}
+
+	// The best of several runs is reported, so that the first run paging in the output buffer is not counted.
+	double best = 0;
+	double checksum = 0;
+	for (int i = 0; i < DmInt_BENCH_RUNS; ++i) {
+		uint64_t start = Dm_getMonotonicTime();
+		(void) DmDls_decodeSamples(wav, samples, sample_count);
+		double elapsed = Dm_getElapsedSeconds(start, Dm_getMonotonicTime());
+
+		if (i == 0 || elapsed < best) {
+			best = elapsed;
+		}
+
+		checksum += samples[(size_t) i * 7919 % sample_count];
+	}
+
+	printf("%-6s %8.1f MB/s in, %8.1f MB/s out, %6.2f ms (checksum %f)\n",
+	       name,
+	       (double) wav->pcm_size / best / 1e6,
+	       (double) (sample_count * sizeof *samples) / best / 1e6,
+	       best * 1e3,
+	       checksum);
+
+	free(samples);
+}
+
+int main(int argc, char** argv) {
+	if (argc > 2) {
+		fputs("Usage: dmusic-bench-decode [MIB]\n\n"
+		      "Measures the throughput of decoding PCM16 and ADPCM wave data, using\n"
+		      "MIB mebibytes of synthetic input (default 16).\n",
+		      stderr);
+		return EXIT_FAILURE;
+	}
+
+	long mib = argc == 2 ? strtol(argv[1], NULL, 10) : DmInt_BENCH_DEFAULT_MIB;
+	if (mib <= 0) {
+		fputs("The input size must be a positive number of mebibytes\n", stderr);
+		return EXIT_FAILURE;
+	}
+
+	size_t len = (size_t) mib * 1024 * 1024;
+	uint8_t* data = malloc(len);
+	if (data == NULL) {
+		fputs("Allocating the input buffer failed\n", stderr);
+		return EXIT_FAILURE;
+	}
+
+	DmBench_fill(data, len);
+
+	DmDlsWave pcm;
+	memset(&pcm, 0, sizeof pcm);
+	pcm.format = DmDlsWaveFormat_PCM;
+	pcm.channels = 1;
+	pcm.bits_per_sample = 16;
+	pcm.block_align = 2;
+	pcm.pcm = data;
+	pcm.pcm_size = (uint32_t) len;
+	DmBench_run("PCM16", &pcm);
+
+	DmDlsWave adpcm;
+	memset(&adpcm, 0, sizeof adpcm);
+	adpcm.format = DmDlsWaveFormat_ADPCM;
+	adpcm.channels = 1;
+	adpcm.bits_per_sample = 4;
+	adpcm.block_align = DmInt_BENCH_ADPCM_BLOCK_ALIGN;
+	adpcm.samples_per_block = (DmInt_BENCH_ADPCM_BLOCK_ALIGN - 7) * 2 + 2;
+	memcpy(adpcm.coefficient_table_0, DmBench_ADPCM_COEFF1, sizeof DmBench_ADPCM_COEFF1);
+	memcpy(adpcm.coefficient_table_1, DmBench_ADPCM_COEFF2, sizeof DmBench_ADPCM_COEFF2);
+	adpcm.pcm = data;
+	adpcm.pcm_size = (uint32_t) len;
+
+	// Every block starts with the index of its predictor, which has to be valid for the block to be decoded.
+	for (size_t i = 0; i < len; i += DmInt_BENCH_ADPCM_BLOCK_ALIGN) {
+		data[i] %= 7;
+	}
+
+	DmBench_run("ADPCM", &adpcm);
+
+	free(data);
+	return EXIT_SUCCESS;
+}
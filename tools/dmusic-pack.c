@@ -0,0 +1,27 @@
+// Copyright © 2024. GothicKit Contributors
+// SPDX-License-Identifier: MIT-Modern-Variant
+#include <dmusic.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char** argv) {
+	if (argc < 3) {
+		fputs("Usage: dmusic-pack <DIRECTORY> <OUTPUT>\n\n"
+		      "Bundles all files in a directory into a single pack file, which can\n"
+		      "be loaded using DmLoader_addPackResolver. Sub-directories are not\n"
+		      "included.\n",
+		      stderr);
+		return EXIT_FAILURE;
+	}
+
+	Dm_setLoggerDefault(DmLogLevel_INFO);
+
+	DmResult rv = Dm_writePack(argv[1], argv[2]);
+	if (rv != DmResult_SUCCESS) {
+		fputs("Creating the pack file failed\n", stderr);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}